@@ -0,0 +1,265 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "capi/alive2.h"
+#include "llvm_util/compare.h"
+#include "llvm_util/utils.h"
+#include "smt/smt.h"
+#include "util/config.h"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/TargetParser/Triple.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace llvm_util;
+using namespace util;
+using namespace std;
+
+struct alive2_session {
+  llvm::LLVMContext Context; // for modules given as IR text
+  smt::smt_initializer smt_init;
+  llvm::StringMap<unique_ptr<llvm::TargetLibraryInfoWrapperPass>> TLIs;
+  stringstream report;
+};
+
+struct alive2_result {
+  alive2_status status = ALIVE2_CORRECT;
+  string report;
+  vector<pair<string, string>> values;
+};
+
+namespace {
+
+alive2_session *current_session = nullptr;
+
+// Applies the limits of a call, and restores the previous ones afterwards
+class LimitsScope {
+  string timeout = smt::get_query_timeout();
+  uint64_t max_mem = smt::get_memory_limit();
+  unsigned src_unroll = config::src_unroll_cnt;
+  unsigned tgt_unroll = config::tgt_unroll_cnt;
+
+public:
+  LimitsScope(const alive2_limits *limits) {
+    if (!limits)
+      return;
+    if (limits->smt_timeout_ms)
+      smt::set_query_timeout(to_string(limits->smt_timeout_ms));
+    if (limits->smt_max_mem_mb)
+      smt::set_memory_limit((uint64_t)limits->smt_max_mem_mb * 1024 * 1024);
+    if (limits->src_unroll)
+      config::src_unroll_cnt = limits->src_unroll;
+    if (limits->tgt_unroll)
+      config::tgt_unroll_cnt = limits->tgt_unroll;
+  }
+
+  ~LimitsScope() {
+    smt::set_query_timeout(std::move(timeout));
+    smt::set_memory_limit(max_mem);
+    config::src_unroll_cnt = src_unroll;
+    config::tgt_unroll_cnt = tgt_unroll;
+  }
+};
+
+unsigned severity(alive2_status status) {
+  switch (status) {
+  case ALIVE2_CORRECT: return 0;
+  case ALIVE2_FAILED:  return 1;
+  case ALIVE2_ERROR:   return 2;
+  case ALIVE2_UNSOUND: return 3;
+  }
+  return 2;
+}
+
+void verify_pair(alive2_session &s, alive2_result &r, llvm::Function &F1,
+                 llvm::Function &F2) {
+  auto &M = *F1.getParent();
+  llvm::Triple targetTriple(M.getTargetTriple());
+  auto &TLI = s.TLIs[targetTriple.str()];
+  if (!TLI)
+    TLI = make_unique<llvm::TargetLibraryInfoWrapperPass>(targetTriple);
+
+  set_outs(s.report);
+  set_data_layout(M.getDataLayout());
+
+  Verifier verifier(*TLI, s.smt_init, s.report);
+  verifier.compareFunctions(F1, F2);
+
+  auto status = verifier.num_unsound ? ALIVE2_UNSOUND :
+                verifier.num_failed  ? ALIVE2_FAILED :
+                verifier.num_errors  ? ALIVE2_ERROR : ALIVE2_CORRECT;
+
+  if (status == ALIVE2_UNSOUND && r.values.empty())
+    r.values = verifier.errs.getExample();
+  if (severity(status) > severity(r.status))
+    r.status = status;
+}
+
+void verify_modules(alive2_session &s, alive2_result &r, llvm::Module &M1,
+                    llvm::Module &M2, const char *fn_name) {
+  if (M1.getTargetTriple() != M2.getTargetTriple()) {
+    s.report << "Modules have different target triples\n";
+    r.status = ALIVE2_ERROR;
+    return;
+  }
+
+  bool found = false;
+  for (auto &F1 : M1) {
+    if (F1.isDeclaration() || F1.getName().empty())
+      continue;
+    if (fn_name && F1.getName() != fn_name)
+      continue;
+
+    auto *F2 = M2.getFunction(F1.getName());
+    if (!F2 || F2->isDeclaration())
+      continue;
+
+    found = true;
+    verify_pair(s, r, F1, *F2);
+  }
+
+  if (!found) {
+    s.report << "No functions to verify\n";
+    r.status = ALIVE2_ERROR;
+  }
+}
+
+unique_ptr<llvm::Module> parse(alive2_session &s, const char *ir,
+                               const char *name) {
+  llvm::SMDiagnostic Diag;
+  auto M = llvm::parseIR(llvm::MemoryBufferRef(ir, name), Diag, s.Context);
+  if (!M) {
+    s.report << "Could not parse " << name << ": " << Diag.getMessage().str()
+             << '\n';
+    return nullptr;
+  }
+  if (llvm::verifyModule(*M)) {
+    s.report << name << " is broken\n";
+    return nullptr;
+  }
+  return M;
+}
+
+alive2_result *finish(alive2_session &s, unique_ptr<alive2_result> r) {
+  r->report = std::move(s.report).str();
+  s.report.str({});
+  return r.release();
+}
+
+}
+
+alive2_session *alive2_session_create(void) {
+  if (current_session)
+    return nullptr;
+
+  auto *s = new alive2_session;
+  static bool llvm_utils_initialized = false;
+  if (!llvm_utils_initialized) {
+    // the data layout is set again for each module verified
+    static llvm::DataLayout DL("");
+    init_llvm_utils(s->report, DL);
+    llvm_utils_initialized = true;
+  }
+  return current_session = s;
+}
+
+void alive2_session_destroy(alive2_session *session) {
+  if (session == current_session)
+    current_session = nullptr;
+  delete session;
+}
+
+alive2_result *alive2_verify_functions(alive2_session *session,
+                                       LLVMValueRef src, LLVMValueRef tgt,
+                                       const alive2_limits *limits) {
+  LimitsScope scope(limits);
+  auto r = make_unique<alive2_result>();
+  auto *F1 = llvm::dyn_cast<llvm::Function>(llvm::unwrap(src));
+  auto *F2 = llvm::dyn_cast<llvm::Function>(llvm::unwrap(tgt));
+  if (!F1 || !F2 || F1->isDeclaration() || F2->isDeclaration()) {
+    session->report << "Expected two function definitions\n";
+    r->status = ALIVE2_ERROR;
+  } else {
+    verify_pair(*session, *r, *F1, *F2);
+  }
+  return finish(*session, std::move(r));
+}
+
+alive2_result *alive2_verify_modules(alive2_session *session,
+                                     LLVMModuleRef src, LLVMModuleRef tgt,
+                                     const char *fn_name,
+                                     const alive2_limits *limits) {
+  LimitsScope scope(limits);
+  auto r = make_unique<alive2_result>();
+  verify_modules(*session, *r, *llvm::unwrap(src), *llvm::unwrap(tgt),
+                 fn_name);
+  return finish(*session, std::move(r));
+}
+
+alive2_result *alive2_verify_ir(alive2_session *session, const char *src_ir,
+                                const char *tgt_ir, const char *fn_name,
+                                const alive2_limits *limits) {
+  LimitsScope scope(limits);
+  auto r = make_unique<alive2_result>();
+  r->status = ALIVE2_ERROR;
+
+  auto M1 = parse(*session, src_ir, "src");
+  if (!M1)
+    return finish(*session, std::move(r));
+
+  if (tgt_ir) {
+    auto M2 = parse(*session, tgt_ir, "tgt");
+    if (M2) {
+      r->status = ALIVE2_CORRECT;
+      verify_modules(*session, *r, *M1, *M2, fn_name);
+    }
+  } else {
+    auto *F1 = M1->getFunction("src");
+    auto *F2 = M1->getFunction("tgt");
+    if (F1 && F2 && !F1->isDeclaration() && !F2->isDeclaration()) {
+      r->status = ALIVE2_CORRECT;
+      verify_pair(*session, *r, *F1, *F2);
+    } else {
+      session->report << "Expected functions @src and @tgt\n";
+    }
+  }
+  return finish(*session, std::move(r));
+}
+
+alive2_status alive2_result_status(const alive2_result *result) {
+  return result->status;
+}
+
+const char *alive2_result_report(const alive2_result *result) {
+  return result->report.c_str();
+}
+
+unsigned alive2_result_num_values(const alive2_result *result) {
+  return result->values.size();
+}
+
+const char *alive2_result_value_name(const alive2_result *result, unsigned i) {
+  return result->values[i].first.c_str();
+}
+
+const char *alive2_result_value(const alive2_result *result, unsigned i) {
+  return result->values[i].second.c_str();
+}
+
+void alive2_result_destroy(alive2_result *result) {
+  delete result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+// C API to embed Alive2's translation validation in other programs, e.g.,
+// to check the candidates of a superoptimizer without starting a process
+// and parsing its output for each one.
+//
+// Alive2 keeps global state (the SMT context, LLVM type caches, etc.), so
+// there can only be one session per process at a time, and it must only be
+// used by one thread at a time.
+//
+// The library is linked against LLVM's shared library, and programs that
+// pass it LLVM objects must use that same library, so there's a single copy
+// of LLVM in the process.
+
+#include "llvm-c/Types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct alive2_session alive2_session;
+typedef struct alive2_result alive2_result;
+
+typedef enum {
+  ALIVE2_CORRECT,  // tgt refines src
+  ALIVE2_UNSOUND,  // found a counterexample
+  ALIVE2_FAILED,   // couldn't prove nor disprove, e.g., due to a timeout
+  ALIVE2_ERROR     // couldn't verify, e.g., unsupported IR or invalid input
+} alive2_status;
+
+// Zero for any field keeps Alive2's default.
+typedef struct {
+  unsigned smt_timeout_ms;  // per SMT query
+  unsigned smt_max_mem_mb;  // approximate
+  unsigned src_unroll;      // loop unrolling factors
+  unsigned tgt_unroll;
+} alive2_limits;
+
+// Returns NULL if there's a session already.
+alive2_session *alive2_session_create(void);
+void alive2_session_destroy(alive2_session *session);
+
+// The limits apply to a single call; they may be NULL.
+
+// Checks that function tgt refines function src.
+alive2_result *alive2_verify_functions(alive2_session *session,
+                                       LLVMValueRef src, LLVMValueRef tgt,
+                                       const alive2_limits *limits);
+
+// Checks that the functions of module tgt refine those with the same name in
+// module src.
+alive2_result *alive2_verify_modules(alive2_session *session,
+                                     LLVMModuleRef src, LLVMModuleRef tgt,
+                                     const char *fn_name,
+                                     const alive2_limits *limits);
+
+// Same as alive2_verify_modules, but for modules given as LLVM IR text.
+// If tgt_ir is NULL, src_ir must have functions @src and @tgt instead.
+// If fn_name isn't NULL, only the function with that name is checked.
+alive2_result *alive2_verify_ir(alive2_session *session, const char *src_ir,
+                                const char *tgt_ir, const char *fn_name,
+                                const alive2_limits *limits);
+
+// When several functions are checked, the status is the worst of them.
+alive2_status alive2_result_status(const alive2_result *result);
+
+// The report, as printed by alive-tv.
+const char *alive2_result_report(const alive2_result *result);
+
+// The values of the inputs in the counterexample, if unsound.
+unsigned alive2_result_num_values(const alive2_result *result);
+const char *alive2_result_value_name(const alive2_result *result, unsigned i);
+const char *alive2_result_value(const alive2_result *result, unsigned i);
+
+void alive2_result_destroy(alive2_result *result);
+
+#ifdef __cplusplus
+}
+#endif
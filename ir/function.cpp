@@ -320,11 +320,16 @@ void Function::syncDataWithSrc(Function &src) {
 
   // copy function decls that are called indirectly
   auto copy_fns = [](const auto &src, auto &dst) {
+    bool changed = false;
     for (auto &c : src.getConstants()) {
       auto *gv = dynamic_cast<const GlobalVariable*>(&c);
-      if (gv && gv->isArbitrarySize() && !dst.getGlobalVar(gv->getName()))
+      if (gv && gv->isArbitrarySize() && !dst.getGlobalVar(gv->getName())) {
         dst.addConstant(make_unique<GlobalVariable>(*gv));
+        changed = true;
+      }
     }
+    if (changed)
+      dst.number();
   };
   copy_fns(src, *this);
   copy_fns(*this, src);
@@ -334,6 +339,120 @@ void Function::syncDataWithSrc(Function &src) {
   }
 }
 
+static unique_ptr<Value> dup_value(const Value &v) {
+  if (auto *c = dynamic_cast<const IntConst*>(&v))
+    return make_unique<IntConst>(*c);
+  if (auto *c = dynamic_cast<const FloatConst*>(&v))
+    return make_unique<FloatConst>(*c);
+  if (auto *c = dynamic_cast<const ConstantInput*>(&v))
+    return make_unique<ConstantInput>(*c);
+  if (auto *u = dynamic_cast<const UndefValue*>(&v))
+    return make_unique<UndefValue>(*u);
+  if (auto *p = dynamic_cast<const PoisonValue*>(&v))
+    return make_unique<PoisonValue>(*p);
+  if (auto *n = dynamic_cast<const NullPointerValue*>(&v))
+    return make_unique<NullPointerValue>(*n);
+  if (auto *gv = dynamic_cast<const GlobalVariable*>(&v))
+    return make_unique<GlobalVariable>(*gv);
+  if (auto *agg = dynamic_cast<const AggregateValue*>(&v))
+    return make_unique<AggregateValue>(*agg);
+  if (auto *in = dynamic_cast<const Input*>(&v))
+    return make_unique<Input>(*in);
+  // ConstantBinOp & friends are only created by the alive parser
+  UNREACHABLE();
+}
+
+using ValueMap = unordered_map<const Value*, Value*>;
+
+static Value* remap_value(Value *v, const ValueMap &vmap);
+
+static void remap_aggregate(AggregateValue &agg, const ValueMap &vmap) {
+  for (auto *elem : vector<Value*>(agg.getVals())) {
+    agg.rauw(*elem, *remap_value(elem, vmap));
+  }
+}
+
+static Value* remap_value(Value *v, const ValueMap &vmap) {
+  if (auto I = vmap.find(v); I != vmap.end())
+    return I->second;
+
+  // aggregates freshly created by Instr::dup still point to the old values
+  if (auto *agg = dynamic_cast<AggregateValue*>(v))
+    remap_aggregate(*agg, vmap);
+  return v;
+}
+
+Function Function::dup() const {
+  assert(predicates.empty());
+  Function f(*type, string(name), bits_pointers, bits_ptr_offset,
+             little_endian, is_var_args);
+  f.attrs = attrs;
+  f.fn_decls = fn_decls;
+
+  ValueMap vmap;
+  auto copy = [&](const auto &from, auto &to) {
+    for (auto &v : from) {
+      auto nv = dup_value(*v);
+      vmap.emplace(v.get(), nv.get());
+      to.emplace_back(std::move(nv));
+    }
+  };
+  copy(constants, f.constants);
+  copy(undefs, f.undefs);
+  copy(inputs, f.inputs);
+  for (auto &agg : aggregates) {
+    auto &nagg = f.aggregates.emplace_back(make_unique<AggregateValue>(*agg));
+    vmap.emplace(agg.get(), nagg.get());
+  }
+  if (returned_input)
+    f.returned_input = vmap.at(returned_input);
+
+  unordered_map<const BasicBlock*, BasicBlock*> bbmap;
+  for (auto *bb : BB_order) {
+    auto &newbb = f.getBB(bb->getName());
+    bbmap.emplace(bb, &newbb);
+    for (auto &i : bb->instrs()) {
+      auto newi = i.dup(f, "");
+      vmap.emplace(&i, newi.get());
+      newbb.addInstr(std::move(newi));
+    }
+  }
+
+  // now that all values exist, make the copies point to each other
+  for (auto &c : f.constants) {
+    if (auto *agg = dynamic_cast<AggregateValue*>(c.get()))
+      remap_aggregate(*agg, vmap);
+  }
+  for (auto &agg : f.aggregates) {
+    remap_aggregate(*agg, vmap);
+  }
+
+  for (auto *bb : BB_order) {
+    auto *newbb = bbmap.at(bb);
+    for (size_t idx = 0, e = newbb->size(); idx != e; ++idx) {
+      auto &i = newbb->at(idx);
+      for (auto *op : i.operands()) {
+        i.rauw(*op, *remap_value(op, vmap));
+      }
+    }
+
+    vector<const BasicBlock*> targets;
+    for (auto &dst : newbb->targets()) {
+      targets.emplace_back(&dst);
+    }
+    for (auto *dst : targets) {
+      if (auto I = bbmap.find(dst); I != bbmap.end())
+        newbb->replaceTargetWith(dst, I->second);
+    }
+
+    for (auto *exit : bb->getExitBlocks()) {
+      newbb->addExitBlock(bbmap.at(exit));
+    }
+  }
+  f.number();
+  return f;
+}
+
 Function::instr_iterator::
 instr_iterator(vector<BasicBlock*>::const_iterator &&BBI,
                vector<BasicBlock*>::const_iterator &&BBE)
@@ -471,6 +590,53 @@ void Function::topSort() {
   BB_order = top_sort(BB_order);
 }
 
+void Function::number() {
+  unsigned n = 1;
+  auto number = [&](auto &vals) {
+    for (auto &v : vals) {
+      v->idx = n++;
+    }
+  };
+  number(constants);
+  number(undefs);
+  number(aggregates);
+  number(inputs);
+
+  for (unsigned i = 0, e = BB_order.size(); i != e; ++i) {
+    auto *bb = BB_order[i];
+    bb->idx = i;
+    for (size_t j = 0, e = bb->size(); j != e; ++j) {
+      bb->at(j).idx = n++;
+    }
+  }
+  num_values = n;
+}
+
+bool Function::isNumbered() const {
+  unsigned n = 1;
+  auto check = [&](auto &vals) {
+    for (auto &v : vals) {
+      if (v->idx != n++)
+        return false;
+    }
+    return true;
+  };
+  if (!check(constants) || !check(undefs) || !check(aggregates) ||
+      !check(inputs))
+    return false;
+
+  for (unsigned i = 0, e = BB_order.size(); i != e; ++i) {
+    auto *bb = BB_order[i];
+    if (bb->idx != i)
+      return false;
+    for (auto &i : bb->instrs()) {
+      if (i.getIndex() != n++)
+        return false;
+    }
+  }
+  return n == num_values;
+}
+
 static void
 rauw_op(const unordered_map<const Value*,
                             vector<pair<BasicBlock*, Value*>>> &vmap,
@@ -27,6 +27,7 @@ class Function;
 class BasicBlock final {
   std::string name;
   std::vector<std::unique_ptr<Instr>> m_instrs;
+  unsigned idx = 0; // position in the function, for State's tables
 
   // If the basic block is a header, this holds all exit blocks of its loop
   // TODO: remove this..
@@ -36,6 +37,7 @@ public:
   BasicBlock(std::string_view name) : name(name) {}
 
   const std::string& getName() const { return name; }
+  unsigned getIndex() const { return idx; }
 
   size_t size() const { return m_instrs.size(); }
   const Instr& at(size_t index) const { return *m_instrs.at(index); }
@@ -72,6 +74,7 @@ public:
   void rauw(const Value &what, Value &with);
 
   friend std::ostream& operator<<(std::ostream &os, const BasicBlock &bb);
+  friend class Function;
 };
 
 
@@ -100,6 +103,9 @@ class Function final {
 
   FnAttrs attrs;
 
+  // number of value indexes given by number()
+  unsigned num_values = 0;
+
   // TODO: Move this to a 'program' class
 public:
   struct FnDecl {
@@ -188,6 +194,9 @@ public:
 
   void syncDataWithSrc(Function &src);
 
+  // deep copy; not supported for functions with preconditions
+  Function dup() const;
+
   auto& getBBs() { return BB_order; }
   const auto& getBBs() const { return BB_order; }
 
@@ -226,6 +235,16 @@ public:
   void topSort();
   void unroll(unsigned k);
 
+  // Gives each value and BB a dense index, for State's tables. Index 0 of
+  // values is reserved for Value::voidVal; BBs are indexed by their position
+  // in the current order. This must be redone after the function changes,
+  // which the code that finalizes functions does: the parsers, dup(),
+  // syncDataWithSrc() and Transform::preprocess().
+  void number();
+  // Whether the indexes given by number() are up to date
+  bool isNumbered() const;
+  unsigned getNumValues() const { return num_values; }
+
   void print(std::ostream &os, bool print_header = true) const;
   friend std::ostream &operator<<(std::ostream &os, const Function &f);
   void writeDot(const char *filename_prefix) const;
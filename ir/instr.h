@@ -472,6 +472,7 @@ public:
   PtrCmpMode getPtrCmpMode() const { return pcmode; }
   void setPtrCmpMode(PtrCmpMode mode) { pcmode = mode; }
   Cond getCond() const { return cond; }
+  unsigned getFlags() const { return flags; }
 
   std::vector<Value*> operands() const override;
   bool propagatesPoison() const override;
@@ -128,6 +128,13 @@ static expr mk_block_if(const expr &cond, expr then, expr els) {
 }
 
 
+static bool same_exprs(const set<expr> &a, const set<expr> &b) {
+  return a.size() == b.size() &&
+         equal(a.begin(), a.end(), b.begin(),
+               [](auto &x, auto &y) { return x.eq(y); });
+}
+
+
 static unsigned next_local_bid;
 static unsigned next_const_bid;
 static unsigned next_global_bid;
@@ -711,12 +718,15 @@ static StateValue bytesToValue(const Memory &m, const vector<Byte> &bytes,
 
 namespace IR {
 
+Memory::AliasSet::AliasSet(size_t num_locals, size_t num_nonlocals)
+  : local(num_locals), non_local(num_nonlocals) {}
+
 Memory::AliasSet::AliasSet(const Memory &m)
-  : local(m.numLocals(), false), non_local(m.numNonlocals(), false) {}
+  : AliasSet(m.numLocals(), m.numNonlocals()) {}
 
 Memory::AliasSet::AliasSet(const Memory &m1, const Memory &m2)
-  : local(max(m1.numLocals(), m2.numLocals()), false),
-    non_local(max(m1.numNonlocals(), m2.numNonlocals()), false) {}
+  : AliasSet(max(m1.numLocals(), m2.numLocals()),
+             max(m1.numNonlocals(), m2.numNonlocals())) {}
 
 size_t Memory::AliasSet::size(bool islocal) const {
   return (islocal ? local : non_local).size();
@@ -724,16 +734,11 @@ size_t Memory::AliasSet::size(bool islocal) const {
 
 int Memory::AliasSet::isFullUpToAlias(bool islocal) const {
   auto &v = islocal ? local : non_local;
-  unsigned i = 0;
-  for (unsigned e = v.size(); i != e; ++i) {
-    if (!v[i])
-      break;
-  }
-  for (unsigned i2 = i, e = v.size(); i2 != e; ++i2) {
-    if (v[i])
-      return -1;
-  }
-  return i - 1;
+  auto i = v.findFirstUnset();
+  // all the remaining bits must be unset
+  if (v.count() != i)
+    return -1;
+  return (int)i - 1;
 }
 
 expr Memory::AliasSet::mayAlias(bool islocal, const expr &bid) const {
@@ -750,48 +755,33 @@ expr Memory::AliasSet::mayAlias(bool islocal, const expr &bid) const {
 }
 
 bool Memory::AliasSet::mayAlias(bool islocal, unsigned bid) const {
-  return (islocal ? local : non_local)[bid];
+  return (islocal ? local : non_local).test(bid);
 }
 
 unsigned Memory::AliasSet::numMayAlias(bool islocal) const {
-  auto &v = islocal ? local : non_local;
-  return count(v.begin(), v.end(), true);
+  return (islocal ? local : non_local).count();
 }
 
 void Memory::AliasSet::setMayAlias(bool islocal, unsigned bid) {
-  (islocal ? local : non_local)[bid] = true;
+  (islocal ? local : non_local).set(bid);
 }
 
 void Memory::AliasSet::setMayAliasUpTo(bool local, unsigned limit) {
-  for (unsigned i = 0; i <= limit; ++i) {
-    setMayAlias(local, i);
-  }
+  (local ? this->local : non_local).setUpTo(limit + 1);
 }
 
 void Memory::AliasSet::setNoAlias(bool islocal, unsigned bid) {
-  (islocal ? local : non_local)[bid] = false;
+  (islocal ? local : non_local).reset(bid);
 }
 
 void Memory::AliasSet::intersectWith(const AliasSet &other) {
-  auto intersect = [](auto &a, const auto &b) {
-    auto I2 = b.begin(), E2 = b.end();
-    for (auto I = a.begin(), E = a.end(); I != E && I2 != E2; ++I, ++I2) {
-      *I = *I && *I2;
-    }
-  };
-  intersect(local, other.local);
-  intersect(non_local, other.non_local);
+  local.intersectWith(other.local);
+  non_local.intersectWith(other.non_local);
 }
 
 void Memory::AliasSet::unionWith(const AliasSet &other) {
-  auto unionfn = [](auto &a, const auto &b) {
-    auto I2 = b.begin(), E2 = b.end();
-    for (auto I = a.begin(), E = a.end(); I != E && I2 != E2; ++I, ++I2) {
-      *I = *I || *I2;
-    }
-  };
-  unionfn(local, other.local);
-  unionfn(non_local, other.non_local);
+  local.unionWith(other.local);
+  non_local.unionWith(other.non_local);
 }
 
 static const array<uint64_t, 5> alias_buckets_vals = { 1, 2, 3, 5, 10 };
@@ -848,8 +838,8 @@ void Memory::AliasSet::printStats(ostream &os) {
 void Memory::AliasSet::print(ostream &os) const {
   auto print = [&](const char *str, const auto &v) {
     os << str;
-    for (auto bit : v) {
-      os << bit;
+    for (size_t i = 0, e = v.size(); i != e; ++i) {
+      os << v.test(i);
     }
   };
 
@@ -1081,8 +1071,8 @@ end:
 
 void Memory::access(const Pointer &ptr, const expr &bytes, uint64_t align,
                     bool write, const
-                      function<void(MemBlock&, const Pointer&, unsigned, bool,
-                                    expr&&)> &fn) {
+                      function<void(const MemBlock&, const Pointer&, unsigned,
+                                    bool, expr&&)> &fn) {
   assert(!ptr.isLogical().isFalse());
   auto aliasing = computeAliasing(ptr, bytes, align, write);
   unsigned has_local = aliasing.numMayAlias(true);
@@ -1154,8 +1144,8 @@ vector<Byte> Memory::load(const Pointer &ptr, unsigned bytes, set<expr> &undef,
   expr poison = Byte::mkPoisonByte(*this)();
   loaded.resize(loaded_bytes, poison);
 
-  auto fn = [&](MemBlock &blk, const Pointer &ptr, unsigned bid, bool local,
-                expr &&cond) {
+  auto fn = [&](const MemBlock &blk, const Pointer &ptr, unsigned bid,
+                bool local, expr &&cond) {
     bool is_poison = (type & blk.type) == DATA_NONE;
     if (is_poison) {
       for (unsigned i = 0; i < loaded_bytes; ++i) {
@@ -1232,8 +1222,9 @@ void Memory::store(const Pointer &ptr,
   auto stored_ty = data_type(data, false);
   auto stored_ty_full = data_type(data, true);
 
-  auto fn = [&](MemBlock &blk, const Pointer &ptr, unsigned bid, bool local,
+  auto fn = [&](const MemBlock&, const Pointer &ptr, unsigned bid, bool local,
                 expr &&cond) {
+    auto &blk = block(local, bid);
     auto mem = blk.val;
 
     uint64_t blk_size;
@@ -1298,8 +1289,9 @@ void Memory::storeLambda(const Pointer &ptr, const expr &offset,
     val = expr::mkIf(offset.urem(mod) == I->first, I->second, val);
   }
 
-  auto fn = [&](MemBlock &blk, const Pointer &ptr, unsigned bid, bool local,
+  auto fn = [&](const MemBlock&, const Pointer &ptr, unsigned bid, bool local,
                 expr &&cond) {
+    auto &blk = block(local, bid);
     auto orig_val = ::raw_load(blk.val, offset);
 
     // optimization: full rewrite
@@ -1327,7 +1319,7 @@ void Memory::storeLambda(const Pointer &ptr, const expr &offset,
     blk.val.isConstArray(blk.val);
 
     if (!local) {
-      auto &set = stored_pointers[bid];
+      auto &set = stored_pointers.mut(bid);
       set.first.clear();
       set.second = true;
     }
@@ -1976,7 +1968,7 @@ void Memory::setState(const Memory::CallState &st,
       = num_nonlocals_src - num_inaccessiblememonly_fns + inaccessible_bid;
     assert(is_fncall_mem(bid));
     assert(non_local_block_val[bid].undef.empty());
-    auto &cur_val = non_local_block_val[bid].val;
+    auto &cur_val = non_local_block_val.mut(bid).val;
     cur_val = mk_block_if(only_write_inaccess && st.writes(0),
                           st.non_local_block_val[0], cur_val);
   }
@@ -2014,22 +2006,23 @@ void Memory::setState(const Memory::CallState &st,
         }
       }
 
-      auto &cur_val = non_local_block_val[bid].val;
       auto &new_val = st.non_local_block_val[idx++];
-      cur_val = mk_block_if(modifies, new_val, std::move(cur_val));
+      if (modifies.isFalse())
+        continue;
+
+      auto &blk = non_local_block_val.mut(bid);
+      blk.val = mk_block_if(modifies, new_val, std::move(blk.val));
       if (modifies.isTrue())
-        non_local_block_val[bid].undef.clear();
+        blk.undef.clear();
 
-      if (!modifies.isFalse()) {
-        auto &stores = stored_pointers[bid];
-        stores.first.clear();
-        stores.second = false;
-      }
+      auto &stores = stored_pointers.mut(bid);
+      stores.first.clear();
+      stores.second = false;
     }
     assert(written_blocks == 0 || idx == written_blocks);
   }
 
-  stored_pointers[get_fncallmem_bid()].second = true;
+  stored_pointers.mut(get_fncallmem_bid()).second = true;
 
   if (!st.non_local_liveness.isAllOnes()) {
     expr one  = expr::mkUInt(1, num_nonlocals);
@@ -2060,7 +2053,7 @@ void Memory::setState(const Memory::CallState &st,
 
     for (unsigned i = 0; i < next_local_bid; ++i) {
       if (escaped_local_blks.mayAlias(true, i)) {
-        local_block_val[i] = expr(zero_byte);
+        local_block_val.mut(i) = expr(zero_byte);
       }
     }
   }
@@ -2212,9 +2205,9 @@ Memory::alloc(const expr *size, uint64_t align, BlockKind blockKind,
 
   if (Pointer(*this, bid, is_local).isBlkSingleByte()) {
     if (is_local)
-      local_block_val[bid].val = Byte::mkPoisonByte(*this)();
+      local_block_val.mut(bid).val = Byte::mkPoisonByte(*this)();
     else
-      non_local_block_val[bid].val = mk_block_val_array(bid);
+      non_local_block_val.mut(bid).val = mk_block_val_array(bid);
   }
 
   if (!nonnull.isTrue()) {
@@ -2505,7 +2498,7 @@ void Memory::copy(const Pointer &src, const Pointer &dst) {
   uint64_t dst_bid;
   expr dst_bid_expr = dst.getShortBid();
   ENSURE(dst_bid_expr.isUInt(dst_bid));
-  auto &dst_blk = (dst_local ? local_block_val : non_local_block_val)[dst_bid];
+  auto &dst_blk = block(dst_local, dst_bid);
   dst_blk.undef.clear();
   dst_blk.type = DATA_NONE;
 
@@ -2516,7 +2509,7 @@ void Memory::copy(const Pointer &src, const Pointer &dst) {
   if (!dst_local)
     record_stored_pointer(dst_bid, offset);
 
-  auto fn = [&](MemBlock &blk, const Pointer &ptr, unsigned src_bid,
+  auto fn = [&](const MemBlock &blk, const Pointer &ptr, unsigned src_bid,
                 bool src_local, expr &&cond) {
     // we assume src != dst
     if (src_local == dst_local && src_bid == dst_bid)
@@ -2804,9 +2797,9 @@ expr Memory::checkInitializes() const {
 }
 
 void Memory::record_stored_pointer(uint64_t bid, const expr &offset) {
-  auto &set = stored_pointers[bid];
-  if (set.second)
+  if (stored_pointers[bid].second)
     return;
+  auto &set = stored_pointers.mut(bid);
   set.first.emplace(offset);
   if (set.first.size() > MAX_STORED_PTRS_SET) {
     set.first.clear();
@@ -2872,21 +2865,31 @@ void Memory::observesAddr(const Pointer &ptr) {
 Memory Memory::mkIf(const expr &cond, Memory &&then, Memory &&els) {
   assert(then.state == els.state);
   Memory &ret = then;
-  for (unsigned bid = 0, end = ret.numNonlocals(); bid < end; ++bid) {
-    if (always_nowrite(bid, false, true))
-      continue;
-    auto &blk   = ret.non_local_block_val[bid];
-    auto &other = els.non_local_block_val[bid];
+
+  // Both memories descend from the same one, and usually most blocks were
+  // written by neither branch. Since expressions are hash-consed, those
+  // blocks still have the very same value, which is cheap to check.
+  auto merge = [&](cow_vector<MemBlock> &blks,
+                   const cow_vector<MemBlock> &others, unsigned bid) {
+    if (blks.same(others, bid))
+      return;
+    auto &other = others[bid];
+    if (blks[bid].val.eq(other.val) && blks[bid].type == other.type &&
+        same_exprs(blks[bid].undef, other.undef))
+      return;
+    auto &blk   = blks.mut(bid);
     blk.val     = mk_block_if(cond, blk.val, other.val);
     blk.type   |= other.type;
     blk.undef.insert(other.undef.begin(), other.undef.end());
+  };
+
+  for (unsigned bid = 0, end = ret.numNonlocals(); bid < end; ++bid) {
+    if (always_nowrite(bid, false, true))
+      continue;
+    merge(ret.non_local_block_val, els.non_local_block_val, bid);
   }
   for (unsigned bid = 0, end = ret.numLocals(); bid < end; ++bid) {
-    auto &blk   = ret.local_block_val[bid];
-    auto &other = els.local_block_val[bid];
-    blk.val     = mk_block_if(cond, blk.val, other.val);
-    blk.type   |= other.type;
-    blk.undef.insert(other.undef.begin(), other.undef.end());
+    merge(ret.local_block_val, els.local_block_val, bid);
   }
   ret.non_local_block_liveness = expr::mkIf(cond, then.non_local_block_liveness,
                                             els.non_local_block_liveness);
@@ -2895,8 +2898,13 @@ Memory Memory::mkIf(const expr &cond, Memory &&then, Memory &&els) {
   ret.has_stored_arg           = expr::mkIf(cond, then.has_stored_arg,
                                             els.has_stored_arg);
   for (size_t i = 0, e = ret.stored_pointers.size(); i != e; ++i) {
-    auto &set1 = ret.stored_pointers[i];
+    if (ret.stored_pointers.same(els.stored_pointers, i))
+      continue;
     auto &set2 = els.stored_pointers[i];
+    if (ret.stored_pointers[i].second == set2.second &&
+        same_exprs(ret.stored_pointers[i].first, set2.first))
+      continue;
+    auto &set1 = ret.stored_pointers.mut(i);
     set1.first.insert(set2.first.begin(), set2.first.end());
     set1.second |= set2.second;
     if (set1.second || set1.first.size() > MAX_STORED_PTRS_SET) {
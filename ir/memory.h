@@ -10,6 +10,8 @@
 #include "ir/type.h"
 #include "smt/expr.h"
 #include "smt/exprs.h"
+#include "util/bitset.h"
+#include "util/cow.h"
 #include "util/spaceship.h"
 #include <compare>
 #include <map>
@@ -103,10 +105,12 @@ public:
 class Memory {
   State *state;
 
+public:
   class AliasSet {
-    std::vector<bool> local, non_local;
+    util::BitSet local, non_local;
 
   public:
+    AliasSet(size_t num_locals, size_t num_nonlocals); // no alias
     AliasSet(const Memory &m); // no alias
     AliasSet(const Memory &m1, const Memory &m2); // no alias
     size_t size(bool local) const;
@@ -132,6 +136,7 @@ class Memory {
     void print(std::ostream &os) const;
   };
 
+private:
   enum DataType { DATA_NONE = 0, DATA_INT = 1, DATA_PTR = 2,
                   DATA_ANY = DATA_INT | DATA_PTR };
 
@@ -148,8 +153,14 @@ class Memory {
     std::weak_ordering operator<=>(const MemBlock &rhs) const;
   };
 
-  std::vector<MemBlock> non_local_block_val;
-  std::vector<MemBlock> local_block_val;
+  // shared between the copies of the memory made at each branch
+  util::cow_vector<MemBlock> non_local_block_val;
+  util::cow_vector<MemBlock> local_block_val;
+
+  // unshares the block, for writing
+  MemBlock& block(bool local, unsigned bid) {
+    return (local ? local_block_val : non_local_block_val).mut(bid);
+  }
 
   smt::expr non_local_block_liveness; // BV w/ 1 bit per bid (1 if live)
   smt::expr local_block_liveness;
@@ -160,7 +171,7 @@ class Memory {
   // record which pointers have been stored to non-local ptrs
   // bid -> offset*, is_set_incomplete
   // when used with a lambda, is_set_incomplete becomes true
-  std::vector<std::pair<std::set<smt::expr>, bool>> stored_pointers;
+  util::cow_vector<std::pair<std::set<smt::expr>, bool>> stored_pointers;
 
   void record_stored_pointer(uint64_t bid, const smt::expr &offset);
 
@@ -209,7 +220,7 @@ class Memory {
 
   void access(const Pointer &ptr, const smt::expr &bytes, uint64_t align,
               bool write,
-              const std::function<void(MemBlock&, const Pointer&, unsigned,
+              const std::function<void(const MemBlock&, const Pointer&, unsigned,
                                        bool, smt::expr&&)> &fn);
 
   std::vector<Byte> load(const Pointer &ptr, unsigned bytes,
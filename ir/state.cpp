@@ -99,17 +99,62 @@ static T intersect_set(const T &a, const T &b) {
   return results;
 }
 
+static void intersect_bits(util::BitSet &a, const util::BitSet &b) {
+  if (a.size() > b.size())
+    a.resize(b.size());
+  a.intersectWith(b);
+}
+
 void State::ValueAnalysis::meet_with(const State::ValueAnalysis &other) {
-  non_poison_vals = intersect_set(non_poison_vals, other.non_poison_vals);
-  non_undef_vals = intersect_set(non_undef_vals, other.non_undef_vals);
-  unused_vars = intersect_set(unused_vars, other.unused_vars);
+  intersect_bits(non_poison_vals, other.non_poison_vals);
+  intersect_bits(unused_vars, other.unused_vars);
+
+  auto &other_non_undef = other.non_undef_vals;
+  if (non_undef_vals.size() > other_non_undef.size())
+    non_undef_vals.resize(other_non_undef.size());
+  for (size_t i = 0, e = non_undef_vals.size(); i != e; ++i) {
+    auto &val = non_undef_vals[i];
+    if (val.isValid() &&
+        (!other_non_undef[i].isValid() || !val.eq(other_non_undef[i])))
+      val = expr();
+  }
+
   ranges_fn_calls.meet_with(other.ranges_fn_calls);
 }
 
 void State::ValueAnalysis::clear_smt() {
   non_poison_vals.clear();
   non_undef_vals = decltype(non_undef_vals)();
-  unused_vars = decltype(unused_vars)();
+  unused_vars.clear();
+}
+
+bool State::ValueAnalysis::has(const util::BitSet &set, const Value &v) {
+  auto idx = v.getIndex();
+  return idx < set.size() && set.test(idx);
+}
+
+bool State::ValueAnalysis::insert(util::BitSet &set, const Value &v) {
+  auto idx = v.getIndex();
+  if (idx >= set.size())
+    set.resize(idx + 1);
+  else if (set.test(idx))
+    return false;
+  set.set(idx);
+  return true;
+}
+
+const expr* State::ValueAnalysis::getNonUndef(const Value &v) const {
+  auto idx = v.getIndex();
+  if (idx < non_undef_vals.size() && non_undef_vals[idx].isValid())
+    return &non_undef_vals[idx];
+  return nullptr;
+}
+
+expr& State::ValueAnalysis::getOrAddNonUndef(const Value &v) {
+  auto idx = v.getIndex();
+  if (idx >= non_undef_vals.size())
+    non_undef_vals.resize(idx + 1);
+  return non_undef_vals[idx];
 }
 
 void State::ValueAnalysis::FnCallRanges::inc(const string &name,
@@ -303,7 +348,15 @@ State::State(const Function &f, bool source)
     fp_rounding_mode(expr::mkVar("fp_rounding_mode", 3)),
     fp_denormal_mode(expr::mkVar("fp_denormal_mode", 2)),
     return_val(DisjointExpr(f.getType().getDummyValue(false))) {
-  predecessor_data.reserve(f.getNumBBs());
+  assert(f.isNumbered());
+  predecessor_data.resize(f.getNumBBs() + 1);
+  seen_bbs.resize(f.getNumBBs() + 1);
+
+  unsigned num_values = f.getNumValues();
+  values.resize(num_values);
+  analysis.non_poison_vals.resize(num_values);
+  analysis.non_undef_vals.resize(num_values);
+  analysis.unused_vars.resize(num_values);
 }
 
 void State::resetGlobals() {
@@ -319,10 +372,14 @@ const State::ValTy& State::exec(const Value &v) {
   if (config::disallow_ub_exploitation)
     value_ub.add(!guardable_ub());
 
-  auto [I, inserted]
-    = values.try_emplace(&v, ValTy{std::move(val), domain.noreturn,
-                                   std::move(value_ub), std::move(undef_vars)});
-  assert(inserted);
+  auto idx = v.getIndex();
+  if (idx >= values.size())
+    values.resize(idx + 1);
+  auto &[slot_val, slot] = values[idx];
+  assert(!slot_val);
+  slot_val = &v;
+  slot = ValTy{std::move(val), domain.noreturn, std::move(value_ub),
+               std::move(undef_vars)};
 
   // As an optimization, record that this value has not yet been used, so
   // we can use this undef variable (if any) on the first use
@@ -332,14 +389,14 @@ const State::ValTy& State::exec(const Value &v) {
   // poison values, it must be converted into a non-det value that must be
   // able to range over the full domain, not just the non-poison domain.
   if (!config::tgt_is_asm)
-    analysis.unused_vars.insert(&v);
+    ValueAnalysis::insert(analysis.unused_vars, v);
 
   // cleanup potentially used temporary values due to undef rewriting
   while (i_tmp_values > 0) {
     tmp_values[--i_tmp_values] = StateValue();
   }
 
-  return I->second;
+  return slot;
 }
 
 static expr eq_except_padding(const Memory &m, const Type &ty, const expr &e1,
@@ -449,9 +506,10 @@ expr State::strip_undef_and_add_ub(const Value &val, const expr &e,
       auto var_name = var.fn_name().substr(sizeof("isundef_")-1);
       // mark the var as non-undef for future uses
       for (auto &[v, val] : values) {
-        if (v->getName() == var_name) {
-          analysis.non_undef_vals
-                  .emplace(v, val.val.value.subst(test, true).simplify());
+        if (v && v->getName() == var_name) {
+          auto &non_undef = analysis.getOrAddNonUndef(*v);
+          if (!non_undef.isValid())
+            non_undef = val.val.value.subst(test, true).simplify();
           break;
         }
       }
@@ -492,11 +550,13 @@ void State::check_enough_tmp_slots() {
 }
 
 const StateValue& State::eval(const Value &val, bool quantify_nondet) {
-  auto &[sval, _retdom, _ub, uvars] = values.at(&val);
+  auto &[val_ptr, val_data] = values.at(val.getIndex());
+  assert(val_ptr == &val);
+  auto &[sval, _retdom, _ub, uvars] = val_data;
 
-  auto undef_itr = analysis.non_undef_vals.find(&val);
-  bool is_non_undef = undef_itr != analysis.non_undef_vals.end();
-  bool is_non_poison = analysis.non_poison_vals.count(&val);
+  auto *non_undef = analysis.getNonUndef(val);
+  bool is_non_undef = non_undef != nullptr;
+  bool is_non_poison = ValueAnalysis::has(analysis.non_poison_vals, val);
 
   auto simplify = [&](StateValue &sv0, bool use_new_slot) -> StateValue& {
     if (!is_non_undef && !is_non_poison)
@@ -509,7 +569,7 @@ const StateValue& State::eval(const Value &val, bool quantify_nondet) {
     assert(i_tmp_values > 0);
     StateValue &sv_new = tmp_values[i_tmp_values - 1];
     if (is_non_undef) {
-      sv_new.value = undef_itr->second;
+      sv_new.value = *non_undef;
     }
     if (is_non_poison) {
       const expr &np = sv_new.non_poison;
@@ -524,11 +584,10 @@ const StateValue& State::eval(const Value &val, bool quantify_nondet) {
     return simplify(sval, true);
   }
 
-  auto unused_itr = analysis.unused_vars.find(&val);
-  bool unused = unused_itr != analysis.unused_vars.end();
+  bool unused = ValueAnalysis::has(analysis.unused_vars, val);
   if (uvars.empty() || unused || disable_undef_rewrite) {
     if (unused)
-      analysis.unused_vars.erase(unused_itr);
+      analysis.unused_vars.reset(val.getIndex());
     undef_vars.insert(uvars.begin(), uvars.end());
     return simplify(sval, true);
   }
@@ -602,18 +661,20 @@ State::getAndAddPoisonUB(const Value &val, bool undef_ub_too,
                          bool ptr_compare) {
   auto &sv = (*this)[val];
 
-  bool poison_already_added = !analysis.non_poison_vals.insert(&val).second;
+  bool poison_already_added
+    = !ValueAnalysis::insert(analysis.non_poison_vals, val);
   if (poison_already_added && !undef_ub_too)
     return sv;
 
   expr v = sv.value;
 
   if (undef_ub_too) {
-    auto [I, inserted] = analysis.non_undef_vals.try_emplace(&val);
-    if (inserted) {
-      I->second = strip_undef_and_add_ub(val, v, ptr_compare);
+    if (auto *non_undef = analysis.getNonUndef(val)) {
+      v = *non_undef;
+    } else {
+      v = strip_undef_and_add_ub(val, v, ptr_compare);
+      analysis.getOrAddNonUndef(val) = v;
     }
-    v = I->second;
   }
 
   if (!poison_already_added) {
@@ -626,7 +687,7 @@ State::getAndAddPoisonUB(const Value &val, bool undef_ub_too,
     while (!todo.empty()) {
       auto v = todo.back();
       todo.pop_back();
-      if (!analysis.non_poison_vals.insert(v).second)
+      if (!ValueAnalysis::insert(analysis.non_poison_vals, *v))
         continue;
       if (auto i = dynamic_cast<const Instr*>(v)) {
         if (i->propagatesPoison()) {
@@ -674,14 +735,28 @@ StateValue State::freeze(const Type &ty, const StateValue &v) {
 }
 
 const State::ValTy* State::at(const Value &val) const {
-  auto I = values.find(&val);
-  return I == values.end() ? nullptr : &I->second;
+  auto idx = val.getIndex();
+  if (idx >= values.size() || values[idx].first != &val)
+    return nullptr;
+  return &values[idx].second;
+}
+
+unsigned State::bbIndex(const BasicBlock &bb) const {
+  return &bb == &f.getSinkBB() ? f.getNumBBs() : bb.getIndex();
+}
+
+const State::BasicBlockInfo*
+State::predecessor(const BasicBlock &dst, const BasicBlock &src) const {
+  for (auto &[bb, data] : predecessor_data[bbIndex(dst)]) {
+    if (bb == &src)
+      return &data;
+  }
+  return nullptr;
 }
 
 const OrExpr* State::jumpCondFrom(const BasicBlock &bb) const {
-  auto &pres = predecessor_data.at(current_bb);
-  auto I = pres.find(&bb);
-  return I == pres.end() ? nullptr : &I->second.path;
+  auto *data = predecessor(*current_bb, bb);
+  return data ? &data->path : nullptr;
 }
 
 bool State::isUndef(const expr &e) const {
@@ -700,27 +775,30 @@ expr State::getPath(BasicBlock &bb) const {
   if (&f.getFirstBB() == &bb)
     return true;
   
-  auto I = predecessor_data.find(&bb);
-  if (I == predecessor_data.end())
+  auto &preds = predecessor_data[bbIndex(bb)];
+  if (preds.empty())
     return false; // Block is unreachable
 
   OrExpr path;
-  for (auto &[src, data] : I->second) {
+  for (auto &[src, data] : preds) {
     path.add(data.path);
   }
   return std::move(path)();
 }
 
 void State::cleanup(const Value &val) {
-  values.erase(&val);
-  seen_bbs.clear();
+  if (auto idx = val.getIndex(); idx < values.size())
+    values[idx] = {};
+  seen_bbs = util::BitSet(seen_bbs.size());
   analysis.unused_vars.clear();
   analysis.non_poison_vals.clear();
   analysis.non_undef_vals.clear();
 }
 
 void State::cleanupPredecessorData() {
-  predecessor_data.clear();
+  for (auto &preds : predecessor_data) {
+    preds.clear();
+  }
 }
 
 void State::copyUBFrom(const BasicBlock &bb) {
@@ -740,20 +818,20 @@ void State::copyUBFrom(const BasicBlock &bb) {
   if (!before_call)
     return;
 
-  auto src_val_I = src_state->values.find(before_call);
-  assert(src_val_I != src_state->values.end());
-  domain.UB.add(src_val_I->second.domain);
+  auto *src_val = src_state->at(*before_call);
+  assert(src_val);
+  domain.UB.add(src_val->domain);
 }
 
-void State::copyUBFromBB(
-  const unordered_map<const BasicBlock*, BasicBlockInfo> &tgt_data) {
+void State::copyUBFromBB(const PredecessorData &tgt_data) {
   auto I = src_bb_paths.find(domain.path);
   if (I == src_bb_paths.end())
     return;
 
   for (auto *src_bb : I->second) {
     bool all_paths_ok = true;
-    for (auto &[_, src_data] : src_state->predecessor_data.at(src_bb)) {
+    for (auto &[_, src_data]
+           : src_state->predecessor_data[src_state->bbIndex(*src_bb)]) {
       auto I = ranges::find_if(tgt_data, [&](const auto &p) {
         return is_eq(p.second.path <=> src_data.path);
       });
@@ -771,7 +849,9 @@ void State::copyUBFromBB(
 
 bool State::startBB(const BasicBlock &bb) {
   assert(undef_vars.empty());
-  ENSURE(seen_bbs.emplace(&bb).second);
+  auto bb_idx = bbIndex(bb);
+  ENSURE(!seen_bbs.test(bb_idx));
+  seen_bbs.set(bb_idx);
   current_bb = &bb;
 
   if (&f.getFirstBB() == &bb) {
@@ -782,8 +862,8 @@ bool State::startBB(const BasicBlock &bb) {
     return true;
   }
 
-  auto I = predecessor_data.find(&bb);
-  if (I == predecessor_data.end())
+  auto &preds = predecessor_data[bb_idx];
+  if (preds.empty())
     return false;
 
   if (hit_memory_limit())
@@ -797,7 +877,7 @@ bool State::startBB(const BasicBlock &bb) {
   domain.UB = AndExpr();
 
   bool isFirst = true;
-  for (auto &[src, data] : I->second) {
+  for (auto &[src, data] : preds) {
     path.add(data.path);
     expr p = data.path();
     UB.add_disj(data.UB, p);
@@ -825,7 +905,7 @@ bool State::startBB(const BasicBlock &bb) {
   var_args_data = *std::move(var_args_in)();
 
   if (src_state)
-    copyUBFromBB(I->second);
+    copyUBFromBB(preds);
 
   return domain;
 }
@@ -838,11 +918,17 @@ void State::addJump(expr &&cond, const BasicBlock &dst0, bool always_jump) {
     return;
 
   auto dst = &dst0;
-  if (seen_bbs.count(dst)) {
+  if (seen_bbs.test(bbIndex(*dst))) {
     dst = &f.getSinkBB();
   }
 
-  auto &data = predecessor_data[dst][current_bb];
+  auto &preds = predecessor_data[bbIndex(*dst)];
+  auto I = ranges::find_if(preds, [&](const auto &p) {
+    return p.first == current_bb;
+  });
+  auto &data = I != preds.end()
+                 ? I->second
+                 : preds.emplace_back(current_bb, BasicBlockInfo()).second;
   if (always_jump) {
     data.mem.add(std::move(memory), cond);
     data.analysis = std::move(analysis);
@@ -1392,9 +1478,12 @@ void State::finishInitializer() {
 
   const Memory *mem = &memory;
   // if we have an init block, the unconditional jump std::moved the memory
-  if (!predecessor_data.empty()) {
-    assert(predecessor_data.size() == 1);
-    mem = &predecessor_data.begin()->second.begin()->second.mem.begin()->first;
+  for (auto &preds : predecessor_data) {
+    if (!preds.empty()) {
+      assert(preds.size() == 1);
+      mem = &preds[0].second.mem.begin()->first;
+      break;
+    }
   }
   return_memory = DisjointExpr(mem->dup());
 
@@ -1417,12 +1506,12 @@ bool State::isImplied(const expr &e, const expr &e_domain) {
 }
 
 expr State::sinkDomain(bool include_ub) const {
-  auto I = predecessor_data.find(&f.getSinkBB());
-  if (I == predecessor_data.end())
+  auto &preds = predecessor_data[bbIndex(f.getSinkBB())];
+  if (preds.empty())
     return false;
 
   OrExpr ret;
-  for (auto &[src, data] : I->second) {
+  for (auto &[src, data] : preds) {
     ret.add(data.path() && (include_ub ? data.UB.factor()() : true));
   }
   return ret();
@@ -1448,13 +1537,8 @@ Memory& State::returnMemory() {
 }
 
 expr State::getJumpCond(const BasicBlock &src, const BasicBlock &dst) const {
-  auto I = predecessor_data.find(&dst);
-  if (I == predecessor_data.end())
-    return false;
-
-  auto J = I->second.find(&src);
-  return J == I->second.end() ? expr(false)
-                              : J->second.path() && J->second.UB.factor()();
+  auto *data = predecessor(dst, src);
+  return data ? data->path() && data->UB.factor()() : expr(false);
 }
 
 void State::addGlobalVarBid(const string &glbvar, unsigned bid) {
@@ -1499,12 +1583,18 @@ void State::syncSEdataWithSrc(State &src) {
   memory.syncWithSrc(src.returnMemory());
 
   src_state = &src;
-  for (auto &[bb, srcs] : src.predecessor_data) {
+  auto &src_bbs = src.f.getBBs();
+  for (unsigned i = 0, e = src.predecessor_data.size(); i != e; ++i) {
+    auto &srcs = src.predecessor_data[i];
+    if (srcs.empty())
+      continue;
+
     OrExpr path;
     for (auto &[src, data] : srcs) {
       path.add(data.path);
     }
-    src_bb_paths[std::move(path)()].emplace_back(bb);
+    src_bb_paths[std::move(path)()].emplace_back(
+      i < src_bbs.size() ? src_bbs[i] : &src.f.getSinkBB());
   }
 }
 
@@ -8,13 +8,13 @@
 #include "ir/state_value.h"
 #include "smt/expr.h"
 #include "smt/exprs.h"
+#include "util/bitset.h"
 #include <array>
 #include <map>
 #include <ostream>
 #include <set>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -84,12 +84,20 @@ private:
     operator bool() const;
   };
 
+  // Indexed by Value::getIndex()
   struct ValueAnalysis {
-    std::set<const Value *> non_poison_vals; // vars that are not poison
+    util::BitSet non_poison_vals; // vars that are not poison
     // vars that are not undef (partially undefs are not allowed too)
-    std::unordered_map<const Value *, smt::expr> non_undef_vals;
+    // An invalid expr if not known.
+    std::vector<smt::expr> non_undef_vals;
     // vars that have never been used
-    std::unordered_set<const Value *> unused_vars;
+    util::BitSet unused_vars;
+
+    static bool has(const util::BitSet &set, const Value &v);
+    // returns false if v was in the set already
+    static bool insert(util::BitSet &set, const Value &v);
+    const smt::expr* getNonUndef(const Value &v) const;
+    smt::expr& getOrAddNonUndef(const Value &v);
 
     // Possible number of calls per function name that occurred so far
     // This is an over-approximation, union over all predecessors
@@ -147,6 +155,11 @@ private:
     VarArgsData var_args;
   };
 
+  // src BB -> BasicBlockInfo, in the order the jumps were added
+  // BBs usually have just a few predecessors, so this is searched linearly.
+  using PredecessorData
+    = std::vector<std::pair<const BasicBlock*, BasicBlockInfo>>;
+
   const Function &f;
   bool source;
   bool disable_undef_rewrite = false;
@@ -166,13 +179,13 @@ private:
   std::set<smt::expr> nondet_vars;
 
   // var -> ((value, not_poison), ub, undef_vars)
-  std::unordered_map<const Value*, ValTy> values;
+  // Indexed by Value::getIndex(); the Value is null if not executed yet.
+  std::vector<std::pair<const Value*, ValTy>> values;
 
   // dst BB -> src BB -> BasicBlockInfo
-  std::unordered_map<const BasicBlock*,
-                     std::unordered_map<const BasicBlock*, BasicBlockInfo>>
-    predecessor_data;
-  std::unordered_set<const BasicBlock*> seen_bbs;
+  // Indexed by bbIndex(); empty if the BB is unreachable.
+  std::vector<PredecessorData> predecessor_data;
+  util::BitSet seen_bbs; // indexed by bbIndex()
 
   // Global variables' memory block ids & Memory::alloc has been called?
   std::unordered_map<std::string, std::pair<unsigned, bool>> glbvar_bids;
@@ -193,8 +206,12 @@ private:
 
   void check_enough_tmp_slots();
   void copyUBFrom(const BasicBlock &bb);
-  void copyUBFromBB(
-    const std::unordered_map<const BasicBlock*, BasicBlockInfo> &tgt_data);
+  void copyUBFromBB(const PredecessorData &tgt_data);
+
+  // the sink BB is shared by all functions; it goes after the function's BBs
+  unsigned bbIndex(const BasicBlock &bb) const;
+  const BasicBlockInfo* predecessor(const BasicBlock &dst,
+                                    const BasicBlock &src) const;
 
   // return_domain: a boolean expression describing return condition
   smt::OrExpr return_domain;
@@ -21,6 +21,7 @@ class VoidValue;
 class Value {
   Type &type;
   std::string name;
+  unsigned idx = 0; // dense index within its function, for State's tables
 
 protected:
   Value(Type &type, std::string &&name)
@@ -33,6 +34,7 @@ public:
   auto& getName() const { return name; }
   auto& getType() const { return type; }
   bool isVoid() const { return type.isVoid(); }
+  unsigned getIndex() const { return idx; }
 
   virtual void rauw(const Value &what, Value &with);
   virtual void print(std::ostream &os) const = 0;
@@ -43,6 +45,7 @@ public:
   static VoidValue voidVal;
 
   friend std::ostream& operator<<(std::ostream &os, const Value &val);
+  friend class Function;
 
   virtual ~Value() {}
 };
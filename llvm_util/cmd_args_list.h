@@ -119,7 +119,8 @@ llvm::cl::opt<bool> opt_alias_stats(LLVM_ARGS_PREFIX "alias-stats",
 
 #ifdef ARGS_REFINEMENT
 llvm::cl::opt<bool> opt_bidirectional(LLVM_ARGS_PREFIX "bidirectional",
-  llvm::cl::desc("Run refinement check in both directions"),
+  llvm::cl::desc("Run refinement check in both directions (the reverse "
+                 "check reuses only the translated functions)"),
   llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
 #endif
 
@@ -8,6 +8,8 @@
 #include "tools/transform.h"
 #include "util/config.h"
 
+#include <algorithm>
+#include <optional>
 #include <sstream>
 #include <utility>
 
@@ -39,16 +41,30 @@ struct Results {
   }
 };
 
+// Translations of a pair of functions that can be reused, in swapped roles,
+// by the reverse check of -bidirectional. This only saves running llvm2alive
+// again; the reverse check still does its own preprocessing, type inference
+// and symbolic execution.
+struct Translations {
+  optional<IR::Function> src, tgt;
+};
+
 Results verify(llvm::Function &F1, llvm::Function &F2,
                llvm::TargetLibraryInfoWrapperPass &TLI,
                smt::smt_initializer &smt_init, ostream &out,
-               bool print_transform, bool always_verify) {
-  auto fn1 = llvm2alive(F1, TLI.getTLI(F1), true);
+               bool print_transform, bool always_verify,
+               Translations *reuse = nullptr, Translations *keep = nullptr) {
+  auto fn1 = reuse && reuse->src ? std::move(reuse->src)
+                                 : llvm2alive(F1, TLI.getTLI(F1), true);
   if (!fn1)
     return Results::Error("Could not translate '" + F1.getName().str() +
                           "' to Alive IR\n");
 
-  auto fn2 = llvm2alive(F2, TLI.getTLI(F2), false, fn1->getGlobalVars());
+  bool fn2_valid_as_src = false;
+  auto fn2 = reuse && reuse->tgt ? std::move(reuse->tgt)
+                                 : llvm2alive(F2, TLI.getTLI(F2), false,
+                                              fn1->getGlobalVars(),
+                                              &fn2_valid_as_src);
   if (!fn2)
     return Results::Error("Could not translate '" + F2.getName().str() +
                           "' to Alive IR\n");
@@ -69,6 +85,19 @@ Results verify(llvm::Function &F1, llvm::Function &F2,
     }
   }
 
+  // Verification changes the functions, so copy them now. The target is
+  // the same as F2 translated as a source if it didn't need anything from
+  // the source. In that case, the source is the same as F1 translated as a
+  // target if there are no globals of F2 for it to import.
+  if (keep && fn2_valid_as_src) {
+    keep->src = r.t.tgt.dup();
+    auto globals = r.t.tgt.getGlobalVars();
+    if (all_of(globals.begin(), globals.end(), [&](auto *gv) {
+          return r.t.src.getGlobalVar(gv->getName()) != nullptr;
+        }))
+      keep->tgt = r.t.src.dup();
+  }
+
   smt_init.reset();
   r.t.preprocess();
   TransformVerify verifier(r.t, false);
@@ -97,7 +126,10 @@ Results verify(llvm::Function &F1, llvm::Function &F2,
 } // namespace
 
 bool Verifier::compareFunctions(llvm::Function &F1, llvm::Function &F2) {
-  auto r = verify(F1, F2, TLI, smt_init, out, !config::quiet, always_verify);
+  Translations reverse;
+  auto r = verify(F1, F2, TLI, smt_init, out, !config::quiet, always_verify,
+                  nullptr, bidirectional ? &reverse : nullptr);
+  errs = r.errs;
   if (r.status == Results::ERROR) {
     out << "ERROR: " << r.error;
     ++num_errors;
@@ -120,7 +152,10 @@ bool Verifier::compareFunctions(llvm::Function &F1, llvm::Function &F2) {
   case Results::SYNTACTIC_EQ:
     out << "Transformation seems to be correct! (syntactically equal)\n\n";
     ++num_correct;
-    break;
+    // the reverse is syntactically equal as well
+    if (bidirectional)
+      out << "These functions seem to be equivalent!\n\n";
+    return true;
 
   case Results::CORRECT:
     out << "Transformation seems to be correct!\n\n";
@@ -147,7 +182,10 @@ bool Verifier::compareFunctions(llvm::Function &F1, llvm::Function &F2) {
   }
 
   if (bidirectional) {
-    r = verify(F2, F1, TLI, smt_init, out, false, always_verify);
+    // Only the translation is shared with the forward check. Symbolic
+    // execution differs for src and tgt, e.g., in how undef values are
+    // quantified and in how memory blocks are numbered.
+    r = verify(F2, F1, TLI, smt_init, out, false, always_verify, &reverse);
     switch (r.status) {
     case Results::ERROR:
     case Results::TYPE_CHECKER_FAILED:
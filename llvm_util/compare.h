@@ -4,6 +4,7 @@
 // Distributed under the MIT license that can be found in the LICENSE file.
 
 #include "smt/smt.h"
+#include "util/errors.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/Function.h"
 #include <ostream>
@@ -21,6 +22,8 @@ struct Verifier {
   bool always_verify = false;
   bool print_dot = false;
   bool bidirectional = false;
+  // of the last pair of functions compared
+  util::Errors errs;
 
   Verifier(llvm::TargetLibraryInfoWrapperPass &TLI,
            smt::smt_initializer &smt_init, std::ostream &out)
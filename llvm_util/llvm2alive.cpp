@@ -123,6 +123,9 @@ class llvm2alive_ : public llvm::InstVisitor<llvm2alive_, unique_ptr<Instr>> {
   /// True if converting a source function, false when converting a target
   /// function.
   bool IsSrc;
+  /// False if a target function was translated differently than it would
+  /// have been as a source function.
+  bool valid_as_src = true;
   vector<llvm::Instruction*> i_constexprs;
   const vector<GlobalVariable*> &gvsInSrc;
   vector<pair<Phi*, llvm::PHINode*>> todo_phis;
@@ -207,6 +210,8 @@ public:
       : f(f), TLI(TLI), IsSrc(IsSrc), gvsInSrc(gvsInSrc),
         out(&get_outs()) {}
 
+  bool isValidAsSrc() const { return valid_as_src; }
+
   ~llvm2alive_() {
     reset_state();
     for (auto &inst : i_constexprs) {
@@ -1462,8 +1467,10 @@ public:
 
         // For the target, dropping metadata is fine as metadata will never turn
         // a incorrect function into a correct one.
-        if (!IsSrc)
+        if (!IsSrc) {
+          valid_as_src = false;
           break;
+        }
         *out << "ERROR: Unsupported metadata: " << ID << '\n';
         return false;
       }
@@ -2086,9 +2093,11 @@ public:
       if (Fn.getGlobalVar(gv->getName())) {
         // ok
       } else if (auto *tgt_gv = getGlobalVariable(name)) {
+        valid_as_src = false;
         if (!get_operand(tgt_gv))
           return {};
       } else {
+        valid_as_src = false;
         // import from src
         // FIXME: this is wrong for IPO
         auto new_var = make_unique<GlobalVariable>(*gv);
@@ -2114,6 +2123,7 @@ public:
     else
       BB->addInstr(make_unique<Branch>(Fn.getBB(entry_name)));
 
+    Fn.number();
     return Fn;
   }
 };
@@ -2127,7 +2137,11 @@ initializer::initializer(ostream &os, const llvm::DataLayout &DL) {
 
 optional<IR::Function>
 llvm2alive(llvm::Function &F, const llvm::TargetLibraryInfo &TLI, bool IsSrc,
-           const vector<GlobalVariable*> &gvsInSrc) {
-  return llvm2alive_(F, TLI, IsSrc, gvsInSrc).run();
+           const vector<GlobalVariable*> &gvsInSrc, bool *valid_as_src) {
+  llvm2alive_ conv(F, TLI, IsSrc, gvsInSrc);
+  auto fn = conv.run();
+  if (valid_as_src)
+    *valid_as_src = conv.isValidAsSrc();
+  return fn;
 }
 }
@@ -21,7 +21,11 @@ struct initializer {
   initializer(std::ostream &os, const llvm::DataLayout &DL);
 };
 
+// If valid_as_src is given, it is set to whether the result is the same as
+// translating F as a source function, i.e., whether a target can be reused
+// as the source of the next transformation.
 std::optional<IR::Function>
 llvm2alive(llvm::Function &F, const llvm::TargetLibraryInfo &TLI, bool IsSrc,
-           const std::vector<IR::GlobalVariable*> &gvsInSrc = {});
+           const std::vector<IR::GlobalVariable*> &gvsInSrc = {},
+           bool *valid_as_src = nullptr);
 }
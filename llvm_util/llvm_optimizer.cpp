@@ -3,18 +3,32 @@
 
 #include "llvm_optimizer.h"
 #include "llvm/Passes/PassBuilder.h"
+#include <optional>
 
 using namespace llvm;
 using namespace std;
 
 namespace llvm_util {
 
-string optimize_module(llvm::Module *M, string_view optArgs) {
+string optimize_module(llvm::Module *M, string_view optArgs,
+                       set<string> *changed_passes) {
   llvm::LoopAnalysisManager LAM;
   llvm::FunctionAnalysisManager FAM;
   llvm::CGSCCAnalysisManager CGAM;
   llvm::ModuleAnalysisManager MAM;
-  llvm::PassBuilder PB;
+  llvm::PassInstrumentationCallbacks PIC;
+  llvm::PassBuilder PB(nullptr, llvm::PipelineTuningOptions(), nullopt,
+                       changed_passes ? &PIC : nullptr);
+
+  if (changed_passes) {
+    PIC.registerAfterPassCallback(
+      [&](llvm::StringRef P, llvm::Any, const llvm::PreservedAnalyses &PA) {
+        // pass managers and adaptors have no name of their own
+        auto name = PIC.getPassNameForClassName(P);
+        if (!name.empty() && !PA.areAllPreserved())
+          changed_passes->emplace(name.str());
+      });
+  }
 
   llvm::ModulePassManager MPM;
 
@@ -3,6 +3,7 @@
 // Copyright (c) 2018-present The Alive2 Authors.
 // Distributed under the MIT license that can be found in the LICENSE file.
 
+#include <set>
 #include <string>
 #include <string_view>
 
@@ -11,5 +12,8 @@ class Module;
 }
 
 namespace llvm_util {
-std::string optimize_module(llvm::Module *M, std::string_view optArgs);
+// If changed_passes is given, the names of the passes that changed M are
+// added to it.
+std::string optimize_module(llvm::Module *M, std::string_view optArgs,
+                            std::set<std::string> *changed_passes = nullptr);
 }
@@ -4,11 +4,15 @@
 #include "llvm_util/utils.h"
 #include "ir/constant.h"
 #include "ir/function.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
@@ -506,6 +510,12 @@ void init_llvm_utils(ostream &os, const llvm::DataLayout &dataLayout) {
   DL = &dataLayout;
 }
 
+void set_data_layout(const llvm::DataLayout &dataLayout) {
+  type_cache.clear();
+  type_id_counter = 0;
+  DL = &dataLayout;
+}
+
 ostream& get_outs() {
   return *out;
 }
@@ -556,4 +566,241 @@ TailCallInfo parse_fn_tailcall(const llvm::CallInst &i) {
   bool has_same_cc = i.getCallingConv() == i.getCaller()->getCallingConv();
   return {tail_type, has_same_cc};
 }
+
+namespace {
+/*
+ * hash of everything in an llvm::Function that llvm2alive looks at: the
+ * instructions with their flags and operands, the attributes, and the
+ * state of the referenced global variables. local values are numbered
+ * in program order; everything else is hashed by content, not address,
+ * as a match skips verification.
+ */
+class Fingerprint {
+  llvm::DenseMap<const llvm::Value*, unsigned> local_ids;
+  llvm::DenseMap<const llvm::Constant*, llvm::hash_code> const_hashes;
+  llvm::DenseMap<const llvm::Type*, llvm::hash_code> type_hashes;
+  llvm::DenseMap<const void*, llvm::hash_code> attr_hashes;
+  llvm::DenseMap<const llvm::Metadata*, llvm::hash_code> md_hashes;
+  llvm::SmallPtrSet<const llvm::GlobalVariable*, 8> seen_globals;
+  llvm::SmallVector<const llvm::GlobalVariable*, 8> globals;
+  llvm::hash_code h;
+
+  void add(llvm::hash_code v) { h = llvm::hash_combine(h, v); }
+
+  llvm::hash_code hashType(const llvm::Type *ty) {
+    if (auto I = type_hashes.find(ty); I != type_hashes.end())
+      return I->second;
+
+    llvm::hash_code th = llvm::hash_value(ty->getTypeID());
+    if (auto *ity = dyn_cast<llvm::IntegerType>(ty)) {
+      th = llvm::hash_combine(th, ity->getBitWidth());
+    } else if (auto *pty = dyn_cast<llvm::PointerType>(ty)) {
+      th = llvm::hash_combine(th, pty->getAddressSpace());
+    } else if (auto *aty = dyn_cast<llvm::ArrayType>(ty)) {
+      th = llvm::hash_combine(th, aty->getNumElements());
+    } else if (auto *vty = dyn_cast<llvm::VectorType>(ty)) {
+      auto ec = vty->getElementCount();
+      th = llvm::hash_combine(th, ec.getKnownMinValue(), ec.isScalable());
+    } else if (auto *sty = dyn_cast<llvm::StructType>(ty)) {
+      th = llvm::hash_combine(th, sty->isPacked(), sty->isOpaque());
+    } else if (auto *fty = dyn_cast<llvm::FunctionType>(ty)) {
+      th = llvm::hash_combine(th, fty->isVarArg());
+    }
+    for (auto *sub : ty->subtypes()) {
+      th = llvm::hash_combine(th, hashType(sub));
+    }
+    type_hashes.try_emplace(ty, th);
+    return th;
+  }
+
+  llvm::hash_code hashAttrs(const llvm::AttributeList &attrs) {
+    auto [I, inserted] = attr_hashes.try_emplace(attrs.getRawPointer());
+    if (inserted) {
+      llvm::hash_code ah = llvm::hash_value(attrs.getNumAttrSets());
+      for (auto &set : attrs) {
+        ah = llvm::hash_combine(ah, set.getAsString());
+      }
+      I->second = ah;
+    }
+    return I->second;
+  }
+
+  llvm::hash_code hashMetadata(const llvm::Metadata *md) {
+    if (!md)
+      return llvm::hash_value(0);
+    if (auto *str = dyn_cast<llvm::MDString>(md))
+      return llvm::hash_combine(1, str->getString());
+    if (auto *val = dyn_cast<llvm::ValueAsMetadata>(md))
+      return llvm::hash_combine(2, hashOperand(val->getValue()));
+
+    // nodes may refer to themselves, e.g., loop IDs
+    auto [I, inserted] = md_hashes.try_emplace(md, llvm::hash_value(3));
+    if (!inserted)
+      return I->second;
+
+    auto *node = cast<llvm::MDNode>(md);
+    llvm::hash_code mh = llvm::hash_combine(4, node->getMetadataID(),
+                                            node->isDistinct());
+    for (auto &op : node->operands()) {
+      mh = llvm::hash_combine(mh, hashMetadata(op));
+    }
+    md_hashes[md] = mh;
+    return mh;
+  }
+
+  llvm::hash_code hashConstant(const llvm::Constant *c) {
+    if (auto *gv = dyn_cast<llvm::GlobalValue>(c)) {
+      if (auto *var = dyn_cast<llvm::GlobalVariable>(gv))
+        if (seen_globals.insert(var).second)
+          globals.push_back(var);
+      // the state of the global variables is hashed separately
+      return llvm::hash_combine(gv->getValueID(), gv->getName());
+    }
+
+    if (auto I = const_hashes.find(c); I != const_hashes.end())
+      return I->second;
+
+    llvm::hash_code ch = llvm::hash_combine(c->getValueID(),
+                                            hashType(c->getType()));
+    if (auto *ci = dyn_cast<llvm::ConstantInt>(c)) {
+      ch = llvm::hash_combine(ch, ci->getValue());
+    } else if (auto *cf = dyn_cast<llvm::ConstantFP>(c)) {
+      ch = llvm::hash_combine(ch, cf->getValueAPF().bitcastToAPInt());
+    } else if (auto *cd = dyn_cast<llvm::ConstantDataSequential>(c)) {
+      ch = llvm::hash_combine(ch, cd->getRawDataValues());
+    } else {
+      if (auto *ce = dyn_cast<llvm::ConstantExpr>(c))
+        ch = llvm::hash_combine(ch, ce->getOpcode(),
+                                ce->getRawSubclassOptionalData());
+      if (auto *gep = dyn_cast<llvm::GEPOperator>(c))
+        ch = llvm::hash_combine(ch, hashType(gep->getSourceElementType()));
+      for (auto &op : c->operands()) {
+        ch = llvm::hash_combine(ch, hashConstant(cast<llvm::Constant>(op)));
+      }
+    }
+    const_hashes.try_emplace(c, ch);
+    return ch;
+  }
+
+  llvm::hash_code hashOperand(const llvm::Value *v) {
+    if (auto *arg = dyn_cast<llvm::Argument>(v))
+      return llvm::hash_combine(1, arg->getArgNo());
+    if (auto I = local_ids.find(v); I != local_ids.end())
+      return llvm::hash_combine(2, I->second);
+    if (auto *c = dyn_cast<llvm::Constant>(v))
+      return hashConstant(c);
+    if (auto *md = dyn_cast<llvm::MetadataAsValue>(v))
+      return llvm::hash_combine(3, hashMetadata(md->getMetadata()));
+    if (auto *asm_ = dyn_cast<llvm::InlineAsm>(v))
+      return llvm::hash_combine(4, hashType(asm_->getFunctionType()),
+                                asm_->getAsmString(),
+                                asm_->getConstraintString(),
+                                asm_->hasSideEffects(),
+                                asm_->isAlignStack(), asm_->getDialect(),
+                                asm_->canThrow());
+    return llvm::hash_combine(5, v->getValueID());
+  }
+
+  void addSpecialState(const llvm::Instruction &i) {
+    if (auto *cmp = dyn_cast<llvm::CmpInst>(&i)) {
+      add(llvm::hash_value(cmp->getPredicate()));
+    } else if (auto *load = dyn_cast<llvm::LoadInst>(&i)) {
+      add(llvm::hash_combine(load->getAlign().value(), load->isVolatile(),
+                             load->getOrdering(), load->getSyncScopeID()));
+    } else if (auto *store = dyn_cast<llvm::StoreInst>(&i)) {
+      add(llvm::hash_combine(store->getAlign().value(), store->isVolatile(),
+                             store->getOrdering(), store->getSyncScopeID()));
+    } else if (auto *alloca = dyn_cast<llvm::AllocaInst>(&i)) {
+      add(llvm::hash_combine(hashType(alloca->getAllocatedType()),
+                             alloca->getAlign().value()));
+    } else if (auto *gep = dyn_cast<llvm::GetElementPtrInst>(&i)) {
+      add(hashType(gep->getSourceElementType()));
+    } else if (auto *call = dyn_cast<llvm::CallBase>(&i)) {
+      add(llvm::hash_combine(hashAttrs(call->getAttributes()),
+                             call->getCallingConv(),
+                             hashType(call->getFunctionType())));
+      if (auto *ci = dyn_cast<llvm::CallInst>(call))
+        add(llvm::hash_value(ci->getTailCallKind()));
+      if (auto *fn = call->getCalledFunction())
+        add(hashAttrs(fn->getAttributes()));
+    } else if (auto *phi = dyn_cast<llvm::PHINode>(&i)) {
+      for (auto *bb : phi->blocks()) {
+        add(hashOperand(bb));
+      }
+    } else if (auto *sv = dyn_cast<llvm::ShuffleVectorInst>(&i)) {
+      add(llvm::hash_combine_range(sv->getShuffleMask().begin(),
+                                   sv->getShuffleMask().end()));
+    } else if (auto *ev = dyn_cast<llvm::ExtractValueInst>(&i)) {
+      add(llvm::hash_combine_range(ev->idx_begin(), ev->idx_end()));
+    } else if (auto *iv = dyn_cast<llvm::InsertValueInst>(&i)) {
+      add(llvm::hash_combine_range(iv->idx_begin(), iv->idx_end()));
+    } else if (auto *rmw = dyn_cast<llvm::AtomicRMWInst>(&i)) {
+      add(llvm::hash_combine(rmw->getOperation(), rmw->getOrdering(),
+                             rmw->getAlign().value(), rmw->isVolatile()));
+    } else if (auto *cx = dyn_cast<llvm::AtomicCmpXchgInst>(&i)) {
+      add(llvm::hash_combine(cx->getSuccessOrdering(),
+                             cx->getFailureOrdering(), cx->isWeak(),
+                             cx->getAlign().value(), cx->isVolatile()));
+    } else if (auto *fence = dyn_cast<llvm::FenceInst>(&i)) {
+      add(llvm::hash_combine(fence->getOrdering(),
+                             fence->getSyncScopeID()));
+    }
+  }
+
+  void addGlobal(const llvm::GlobalVariable &gv) {
+    add(llvm::hash_combine(gv.getName(), hashType(gv.getValueType()),
+                           gv.isConstant(), gv.getAlign().valueOrOne().value(),
+                           gv.getLinkage(), gv.getAddressSpace(),
+                           gv.hasInitializer()));
+    if (gv.hasInitializer())
+      add(hashConstant(gv.getInitializer()));
+  }
+
+public:
+  uint64_t run(const llvm::Function &F) {
+    unsigned id = 0;
+    for (auto &bb : F) {
+      local_ids.try_emplace(&bb, id++);
+      for (auto &i : bb) {
+        local_ids.try_emplace(&i, id++);
+      }
+    }
+
+    h = llvm::hash_combine(hashType(F.getFunctionType()),
+                           hashAttrs(F.getAttributes()),
+                           F.getCallingConv(), F.isVarArg());
+
+    // llvm2alive ignores debug locations
+    llvm::SmallVector<pair<unsigned, llvm::MDNode*>, 4> mds;
+    for (auto &bb : F) {
+      add(llvm::hash_value(bb.size()));
+      for (auto &i : bb) {
+        add(llvm::hash_combine(i.getOpcode(), hashType(i.getType()),
+                               i.getRawSubclassOptionalData()));
+        for (auto &op : i.operands()) {
+          add(hashOperand(op));
+        }
+        addSpecialState(i);
+
+        i.getAllMetadataOtherThanDebugLoc(mds);
+        for (auto &[kind, md] : mds) {
+          add(llvm::hash_combine(kind, hashMetadata(md)));
+        }
+      }
+    }
+
+    // globals may have been modified even if the function was not
+    // (e.g., marked constant); llvm2alive translates their state too.
+    // initializers may reference further globals, which get appended
+    for (unsigned idx = 0; idx != globals.size(); ++idx) {
+      addGlobal(*globals[idx]);
+    }
+    return (uint64_t)(size_t)h;
+  }
+};
+}
+
+uint64_t fingerprint(const llvm::Function &F) {
+  return Fingerprint().run(F);
+}
 }
@@ -59,6 +59,8 @@ PRINT(llvm::Value)
 #undef PRINT
 
 void init_llvm_utils(std::ostream &os, const llvm::DataLayout &DL);
+// switches to the data layout of another module; drops the translated types
+void set_data_layout(const llvm::DataLayout &DL);
 
 std::ostream& get_outs();
 void set_outs(std::ostream &os);
@@ -71,4 +73,8 @@ std::unique_ptr<llvm::Module> openInputFile(llvm::LLVMContext &Context,
 llvm::Function *findFunction(llvm::Module &M, const std::string &FName);
 
 IR::TailCallInfo parse_fn_tailcall(const llvm::CallInst &i);
+
+// cheap hash of the parts of a function that llvm2alive translates; used to
+// detect functions that were not modified
+uint64_t fingerprint(const llvm::Function &F);
 }
@@ -0,0 +1,122 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+// Microbenchmark of Memory::AliasSet, which the memory model copies, merges
+// and queries for every pointer. Build it with the aliasset-bench target;
+// the optional argument is the number of iterations of each operation.
+
+#include "ir/memory.h"
+#include "smt/expr.h"
+#include "smt/smt.h"
+#include "util/stopwatch.h"
+#include <compare>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace IR;
+using namespace smt;
+using namespace std;
+using namespace util;
+
+namespace {
+
+using AliasSet = Memory::AliasSet;
+
+// keeps the results alive
+unsigned checksum = 0;
+
+void bench(const char *name, size_t bits, unsigned iters,
+           const function<void(unsigned)> &op) {
+  StopWatch sw;
+  for (unsigned i = 0; i < iters; ++i) {
+    op(i);
+  }
+  sw.stop();
+  printf("%-16s %5zu blocks %10.1f ns/op\n", name, bits,
+         sw.seconds() * 1e9 / iters);
+}
+
+// roughly one in three blocks may alias
+AliasSet random_set(size_t bits, mt19937 &rand) {
+  AliasSet set(bits, bits);
+  for (unsigned i = 0; i < bits; ++i) {
+    if (rand() % 3 == 0) {
+      set.setMayAlias(true, i);
+      set.setMayAlias(false, i);
+    }
+  }
+  return set;
+}
+
+}
+
+int main(int argc, char **argv) {
+  unsigned iters = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  smt_initializer smt_init;
+  mt19937 rand(0);
+
+  for (size_t bits : { 8, 64, 128, 1024 }) {
+    vector<AliasSet> sets;
+    for (unsigned i = 0; i < 16; ++i) {
+      sets.emplace_back(random_set(bits, rand));
+    }
+    // the common case of an argument that may alias every global
+    AliasSet full(bits, bits);
+    full.setMayAliasUpTo(false, bits - 1);
+    sets[0] = full;
+
+    auto at = [&](unsigned i) -> const AliasSet& {
+      return sets[i % sets.size()];
+    };
+    vector<AliasSet> scratch;
+
+    bench("copy", bits, iters, [&](unsigned i) {
+      AliasSet copy(at(i));
+      checksum += copy.size(true);
+    });
+
+    scratch = sets;
+    bench("set", bits, iters, [&](unsigned i) {
+      scratch[i % scratch.size()].setMayAlias(true, i % bits);
+    });
+
+    scratch = sets;
+    bench("set-up-to", bits, iters, [&](unsigned i) {
+      scratch[i % scratch.size()].setMayAliasUpTo(true, i % bits);
+    });
+
+    scratch = sets;
+    bench("union", bits, iters, [&](unsigned i) {
+      scratch[i % scratch.size()].unionWith(at(i + 1));
+    });
+
+    scratch = sets;
+    bench("intersect", bits, iters, [&](unsigned i) {
+      scratch[i % scratch.size()].intersectWith(at(i + 1));
+    });
+
+    bench("compare", bits, iters, [&](unsigned i) {
+      checksum += is_lt(at(i) <=> at(i + 1));
+    });
+
+    bench("full-up-to", bits, iters, [&](unsigned i) {
+      checksum += at(i).isFullUpToAlias(false);
+    });
+
+    bench("count", bits, iters, [&](unsigned i) {
+      checksum += at(i).numMayAlias(true);
+    });
+
+    // builds SMT expressions, so it's much slower
+    auto bid = expr::mkVar("bid", 16);
+    bench("may-alias-expr", bits, max(1u, iters / 100), [&](unsigned i) {
+      checksum += at(i).mayAlias(false, bid).isFalse();
+    });
+  }
+
+  printf("checksum: %u\n", checksum);
+  return 0;
+}
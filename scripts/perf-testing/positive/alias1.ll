@@ -0,0 +1,21 @@
+; X stack blocks that a single pointer may alias, to stress alias sets
+define(`BLOCKS', `ifelse(eval($1 > X), 1, , `  %p$1 = alloca i32
+  store i32 $1, ptr %p$1
+  %c$1 = icmp eq i32 %n, $1
+  %s$1 = select i1 %c$1, ptr %p$1, ptr %s`'decr($1)
+BLOCKS(incr($1))')')dnl
+
+define i32 @src(i32 %n, ptr %q) {
+  %s0 = getelementptr i8, ptr %q, i64 0
+BLOCKS(1)dnl
+  store i32 0, ptr %s`'X
+  %v = load i32, ptr %s`'X
+  ret i32 %v
+}
+
+define i32 @tgt(i32 %n, ptr %q) {
+  %s0 = getelementptr i8, ptr %q, i64 0
+BLOCKS(1)dnl
+  store i32 0, ptr %s`'X
+  ret i32 0
+}
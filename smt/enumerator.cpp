@@ -0,0 +1,613 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "smt/enumerator.h"
+#include "smt/ctx.h"
+#include "util/compiler.h"
+#include <algorithm>
+#include <cassert>
+#include <z3.h>
+
+using namespace smt;
+using namespace std;
+
+// enumerating larger domains is better left to the solver
+static constexpr unsigned max_var_bits = 16;
+
+static uint64_t mask(unsigned bits) {
+  return bits >= 64 ? UINT64_MAX : (UINT64_C(1) << bits) - 1;
+}
+
+static int64_t sext(uint64_t v, unsigned bits) {
+  if (bits == 0 || bits >= 64)
+    return (int64_t)v;
+  unsigned shift = 64 - bits;
+  return (int64_t)(v << shift) >> shift;
+}
+
+namespace smt {
+
+ModelEnumerator::ModelEnumerator(const expr &e) {
+  unordered_map<Z3_ast, unsigned> map;
+  compile(e(), map);
+  if (!supported)
+    return;
+
+  rep.resize(vars.size());
+  for (unsigned i = 0, n = vars.size(); i != n; ++i) {
+    rep[i] = i;
+  }
+  unify(nodes.size() - 1);
+  assignment.resize(vars.size());
+  vals.resize(nodes.size());
+}
+
+unsigned ModelEnumerator::compile(Z3_ast ast,
+                                  unordered_map<Z3_ast, unsigned> &map) {
+  if (auto I = map.find(ast); I != map.end())
+    return I->second;
+
+  auto unsupported = [&]() {
+    supported = false;
+    return 0u;
+  };
+
+  auto kind = Z3_get_ast_kind(ctx(), ast);
+  if (kind != Z3_APP_AST && kind != Z3_NUMERAL_AST)
+    return unsupported();
+
+  Node n;
+  auto sort = Z3_get_sort(ctx(), ast);
+  switch (Z3_get_sort_kind(ctx(), sort)) {
+  case Z3_BOOL_SORT:
+    n.bits = 0;
+    break;
+  case Z3_BV_SORT:
+    n.bits = Z3_get_bv_sort_size(ctx(), sort);
+    if (n.bits > 64)
+      return unsupported();
+    break;
+  default:
+    return unsupported();
+  }
+
+  auto app = Z3_to_app(ctx(), ast);
+  auto decl = Z3_get_app_decl(ctx(), app);
+  n.op = Z3_get_decl_kind(ctx(), decl);
+
+  switch (n.op) {
+  case Z3_OP_TRUE:
+  case Z3_OP_FALSE:
+    break;
+
+  case Z3_OP_BNUM:
+    ENSURE(Z3_get_numeral_uint64(ctx(), ast, &n.val));
+    break;
+
+  case Z3_OP_UNINTERPRETED:
+    if (Z3_get_app_num_args(ctx(), app) != 0 || n.bits > max_var_bits)
+      return unsupported();
+    n.var = vars.size();
+    vars.emplace_back(expr(ast));
+    break;
+
+  case Z3_OP_EXTRACT:
+    n.hi = Z3_get_decl_int_parameter(ctx(), decl, 0);
+    n.lo = Z3_get_decl_int_parameter(ctx(), decl, 1);
+    [[fallthrough]];
+  case Z3_OP_EQ:
+  case Z3_OP_DISTINCT:
+  case Z3_OP_ITE:
+  case Z3_OP_AND:
+  case Z3_OP_OR:
+  case Z3_OP_XOR:
+  case Z3_OP_NOT:
+  case Z3_OP_IMPLIES:
+  case Z3_OP_BNEG:
+  case Z3_OP_BADD:
+  case Z3_OP_BSUB:
+  case Z3_OP_BMUL:
+  case Z3_OP_BUDIV:
+  case Z3_OP_BUDIV_I:
+  case Z3_OP_BUREM:
+  case Z3_OP_BUREM_I:
+  case Z3_OP_ULEQ:
+  case Z3_OP_SLEQ:
+  case Z3_OP_UGEQ:
+  case Z3_OP_SGEQ:
+  case Z3_OP_ULT:
+  case Z3_OP_SLT:
+  case Z3_OP_UGT:
+  case Z3_OP_SGT:
+  case Z3_OP_BAND:
+  case Z3_OP_BOR:
+  case Z3_OP_BNOT:
+  case Z3_OP_BXOR:
+  case Z3_OP_BSHL:
+  case Z3_OP_BLSHR:
+  case Z3_OP_CONCAT:
+  case Z3_OP_ZERO_EXT:
+  case Z3_OP_SIGN_EXT:
+    for (unsigned i = 0, e = Z3_get_app_num_args(ctx(), app); i != e; ++i) {
+      n.args.push_back(compile(Z3_get_app_arg(ctx(), app, i), map));
+      if (!supported)
+        return 0;
+    }
+    break;
+
+  default:
+    return unsupported();
+  }
+
+  unsigned idx = nodes.size();
+  if (n.op == Z3_OP_UNINTERPRETED)
+    var_node.push_back(idx);
+  nodes.emplace_back(std::move(n));
+  map.emplace(ast, idx);
+  return idx;
+}
+
+// Unifies the variables equated by the top-level conjuncts. The equalities
+// themselves become trivially true.
+void ModelEnumerator::unify(unsigned node) {
+  auto &n = nodes[node];
+  if (n.op == Z3_OP_AND) {
+    for (auto arg : n.args) {
+      unify(arg);
+    }
+  } else if (n.op == Z3_OP_EQ) {
+    auto &a = nodes[n.args[0]], &b = nodes[n.args[1]];
+    if (a.op == Z3_OP_UNINTERPRETED && b.op == Z3_OP_UNINTERPRETED &&
+        a.bits == b.bits) {
+      auto ra = find(a.var), rb = find(b.var);
+      rep[max(ra, rb)] = min(ra, rb);
+      n.op = Z3_OP_TRUE;
+      n.args.clear();
+    }
+  }
+}
+
+unsigned ModelEnumerator::find(unsigned var) const {
+  while (rep[var] != var) {
+    var = rep[var];
+  }
+  return var;
+}
+
+void ModelEnumerator::eval() {
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i) {
+    auto &n = nodes[i];
+    auto &r = vals[i];
+    auto arg = [&](unsigned idx) -> const Val& { return vals[n.args[idx]]; };
+    auto all_known = [&]() {
+      return all_of(n.args.begin(), n.args.end(),
+                    [&](unsigned a) { return vals[a].known; });
+    };
+    auto set = [&](uint64_t v) {
+      r.known = true;
+      r.v = v & mask(n.bits == 0 ? 1 : n.bits);
+    };
+    r.known = false;
+
+    switch (n.op) {
+    case Z3_OP_TRUE:
+      set(1);
+      break;
+    case Z3_OP_FALSE:
+      set(0);
+      break;
+    case Z3_OP_BNUM:
+      set(n.val);
+      break;
+    case Z3_OP_UNINTERPRETED:
+      if (auto &v = assignment[find(n.var)])
+        set(*v);
+      break;
+
+    case Z3_OP_AND:
+    case Z3_OP_OR: {
+      // the absorbing value wins even if other arguments are unknown
+      bool absorb = n.op == Z3_OP_OR;
+      bool all = true;
+      for (auto a : n.args) {
+        auto &v = vals[a];
+        if (v.known && v.v == absorb) {
+          set(absorb);
+          break;
+        }
+        all &= v.known;
+      }
+      if (!r.known && all)
+        set(!absorb);
+      break;
+    }
+    case Z3_OP_IMPLIES:
+      if ((arg(0).known && !arg(0).v) || (arg(1).known && arg(1).v))
+        set(1);
+      else if (arg(0).known && arg(1).known)
+        set(0);
+      break;
+    case Z3_OP_ITE:
+      if (arg(0).known)
+        r = arg(arg(0).v ? 1 : 2);
+      else if (arg(1).known && arg(2).known && arg(1).v == arg(2).v)
+        r = arg(1);
+      break;
+
+    default:
+      if (!all_known())
+        break;
+
+      switch (n.op) {
+      case Z3_OP_EQ:
+        set(arg(0).v == arg(1).v);
+        break;
+      case Z3_OP_DISTINCT: {
+        bool distinct = true;
+        for (unsigned i = 0, e = n.args.size(); i != e; ++i) {
+          for (unsigned j = i + 1; j != e; ++j) {
+            distinct &= arg(i).v != arg(j).v;
+          }
+        }
+        set(distinct);
+        break;
+      }
+      case Z3_OP_XOR:
+        set(arg(0).v != arg(1).v);
+        break;
+      case Z3_OP_NOT:
+        set(!arg(0).v);
+        break;
+      case Z3_OP_BNEG:
+        set(-arg(0).v);
+        break;
+      case Z3_OP_BNOT:
+        set(~arg(0).v);
+        break;
+      case Z3_OP_BADD:
+      case Z3_OP_BMUL:
+      case Z3_OP_BAND:
+      case Z3_OP_BOR:
+      case Z3_OP_BXOR: {
+        uint64_t v = arg(0).v;
+        for (unsigned i = 1, e = n.args.size(); i != e; ++i) {
+          auto a = arg(i).v;
+          switch (n.op) {
+          case Z3_OP_BADD: v += a; break;
+          case Z3_OP_BMUL: v *= a; break;
+          case Z3_OP_BAND: v &= a; break;
+          case Z3_OP_BOR:  v |= a; break;
+          case Z3_OP_BXOR: v ^= a; break;
+          }
+        }
+        set(v);
+        break;
+      }
+      case Z3_OP_BSUB:
+        set(arg(0).v - arg(1).v);
+        break;
+      case Z3_OP_BUDIV:
+      case Z3_OP_BUDIV_I:
+        set(arg(1).v == 0 ? UINT64_MAX : arg(0).v / arg(1).v);
+        break;
+      case Z3_OP_BUREM:
+      case Z3_OP_BUREM_I:
+        set(arg(1).v == 0 ? arg(0).v : arg(0).v % arg(1).v);
+        break;
+      case Z3_OP_ULEQ:
+        set(arg(0).v <= arg(1).v);
+        break;
+      case Z3_OP_UGEQ:
+        set(arg(0).v >= arg(1).v);
+        break;
+      case Z3_OP_ULT:
+        set(arg(0).v < arg(1).v);
+        break;
+      case Z3_OP_UGT:
+        set(arg(0).v > arg(1).v);
+        break;
+      case Z3_OP_SLEQ:
+      case Z3_OP_SGEQ:
+      case Z3_OP_SLT:
+      case Z3_OP_SGT: {
+        auto bits = nodes[n.args[0]].bits;
+        auto a = sext(arg(0).v, bits), b = sext(arg(1).v, bits);
+        set(n.op == Z3_OP_SLEQ ? a <= b :
+            n.op == Z3_OP_SGEQ ? a >= b :
+            n.op == Z3_OP_SLT  ? a < b : a > b);
+        break;
+      }
+      case Z3_OP_BSHL:
+        set(arg(1).v >= n.bits ? 0 : arg(0).v << arg(1).v);
+        break;
+      case Z3_OP_BLSHR:
+        set(arg(1).v >= n.bits ? 0 : arg(0).v >> arg(1).v);
+        break;
+      case Z3_OP_CONCAT: {
+        uint64_t v = 0;
+        for (unsigned i = 0, e = n.args.size(); i != e; ++i) {
+          auto bits = nodes[n.args[i]].bits;
+          v = (bits >= 64 ? 0 : v << bits) | arg(i).v;
+        }
+        set(v);
+        break;
+      }
+      case Z3_OP_EXTRACT:
+        set(arg(0).v >> n.lo);
+        break;
+      case Z3_OP_ZERO_EXT:
+        set(arg(0).v);
+        break;
+      case Z3_OP_SIGN_EXT:
+        set(sext(arg(0).v, nodes[n.args[0]].bits));
+        break;
+      default:
+        UNREACHABLE();
+      }
+    }
+  }
+}
+
+// Narrows the domains of the variables with the comparisons against known
+// values the formula requires to hold given the current partial assignment.
+void ModelEnumerator::bounds(vector<Frame> &dom) const {
+  dom.resize(vars.size());
+  for (unsigned i = 0, e = vars.size(); i != e; ++i) {
+    auto bits = nodes[var_node[i]].bits;
+    dom[i] = { i, 0, mask(bits == 0 ? 1 : bits) };
+  }
+
+  auto known = [&](unsigned i) { return vals[i].known; };
+  auto val = [&](unsigned i) { return vals[i].v; };
+  auto var = [&](unsigned i) -> Frame* {
+    auto &n = nodes[i];
+    return n.op == Z3_OP_UNINTERPRETED ? &dom[find(n.var)] : nullptr;
+  };
+  auto empty = [](Frame &d) { d.next = 1; d.last = 0; };
+  auto at_most = [](Frame &d, uint64_t v) { d.last = min(d.last, v); };
+  auto at_least = [](Frame &d, uint64_t v) { d.next = max(d.next, v); };
+
+  // a <= b (or a > b if !pol)
+  auto ule = [&](unsigned a, unsigned b, bool pol) {
+    if (auto *d = var(a); d && known(b)) {
+      if (pol)
+        at_most(*d, val(b));
+      else if (val(b) == UINT64_MAX)
+        empty(*d);
+      else
+        at_least(*d, val(b) + 1);
+    } else if (auto *d = var(b); d && known(a)) {
+      if (pol)
+        at_least(*d, val(a));
+      else if (val(a) == 0)
+        empty(*d);
+      else
+        at_most(*d, val(a) - 1);
+    }
+  };
+
+  // a == b (or a != b if !pol)
+  auto eq = [&](unsigned a, unsigned b, bool pol) {
+    if (!var(a))
+      swap(a, b);
+    auto *d = var(a);
+    if (!d || !known(b))
+      return;
+    auto v = val(b);
+    if (pol) {
+      at_least(*d, v);
+      at_most(*d, v);
+    } else if (v == d->next && v == d->last) {
+      empty(*d);
+    } else if (v == d->next) {
+      ++d->next;
+    } else if (v == d->last) {
+      --d->last;
+    }
+  };
+
+  vector<bool> seen[2] = { vector<bool>(nodes.size()),
+                           vector<bool>(nodes.size()) };
+  vector<pair<unsigned, bool>> todo = { { nodes.size() - 1, true } };
+
+  while (!todo.empty()) {
+    auto [i, pol] = todo.back();
+    todo.pop_back();
+    if (known(i) || seen[pol][i])
+      continue;
+    seen[pol][i] = true;
+
+    auto &n = nodes[i];
+    auto &args = n.args;
+
+    // if all arguments but one have the given value, returns that one
+    auto single_other = [&](bool v) -> optional<unsigned> {
+      optional<unsigned> other;
+      for (auto a : args) {
+        if (known(a) && val(a) == v)
+          continue;
+        if (other)
+          return {};
+        other = a;
+      }
+      return other;
+    };
+
+    switch (n.op) {
+    case Z3_OP_UNINTERPRETED:
+      pol ? at_least(*var(i), 1) : at_most(*var(i), 0);
+      break;
+    case Z3_OP_NOT:
+      todo.emplace_back(args[0], !pol);
+      break;
+    case Z3_OP_AND:
+    case Z3_OP_OR:
+      // and = true / or = false require all arguments to be the same
+      if (pol == (n.op == Z3_OP_AND)) {
+        for (auto a : args) {
+          todo.emplace_back(a, pol);
+        }
+      } else if (auto other = single_other(!pol)) {
+        todo.emplace_back(*other, pol);
+      }
+      break;
+    case Z3_OP_IMPLIES:
+      if (!pol) {
+        todo.emplace_back(args[0], true);
+        todo.emplace_back(args[1], false);
+      } else if (known(args[0])) {
+        todo.emplace_back(args[1], true);
+      } else if (known(args[1])) {
+        todo.emplace_back(args[0], false);
+      }
+      break;
+    case Z3_OP_ITE:
+      if (known(args[0]))
+        todo.emplace_back(args[val(args[0]) ? 1 : 2], pol);
+      break;
+    case Z3_OP_EQ:
+      eq(args[0], args[1], pol);
+      break;
+    case Z3_OP_DISTINCT:
+      if (args.size() == 2)
+        eq(args[0], args[1], !pol);
+      break;
+    case Z3_OP_ULEQ:
+      ule(args[0], args[1], pol);
+      break;
+    case Z3_OP_UGEQ:
+      ule(args[1], args[0], pol);
+      break;
+    case Z3_OP_ULT:
+      ule(args[1], args[0], !pol);
+      break;
+    case Z3_OP_UGT:
+      ule(args[0], args[1], !pol);
+      break;
+    }
+  }
+}
+
+// Returns an unassigned variable the formula depends on.
+// Follows the first undecided argument of the boolean connectives from the
+// root, and then picks the variable with the smallest domain in the atom
+// reached. Type constraints are written guard first (e.g., the type of a
+// value before its bit-width, or the number of elements of a vector before
+// the elements), so guards are assigned before the variables they may make
+// irrelevant.
+ModelEnumerator::Frame ModelEnumerator::pickVar() const {
+  vector<Frame> dom;
+  bounds(dom);
+
+  auto known = [&](unsigned i) { return vals[i].known; };
+  unsigned i = nodes.size() - 1;
+  while (true) {
+    auto &n = nodes[i];
+    assert(!known(i));
+
+    switch (n.op) {
+    case Z3_OP_AND:
+    case Z3_OP_OR:
+    case Z3_OP_NOT:
+    case Z3_OP_IMPLIES:
+    case Z3_OP_XOR:
+      i = *find_if(n.args.begin(), n.args.end(),
+                   [&](unsigned a) { return !known(a); });
+      continue;
+    case Z3_OP_ITE:
+      if (n.bits == 0) {
+        i = n.args[known(n.args[0]) ? (vals[n.args[0]].v ? 1 : 2) : 0];
+        continue;
+      }
+      break;
+    }
+    break;
+  }
+
+  auto size = [](const Frame &d) {
+    return d.next > d.last ? 0 : d.last - d.next + 1;
+  };
+
+  vector<bool> seen(nodes.size());
+  vector<unsigned> todo = { i };
+  const Frame *best = nullptr;
+
+  while (!todo.empty()) {
+    auto i = todo.back();
+    todo.pop_back();
+    if (seen[i] || known(i))
+      continue;
+    seen[i] = true;
+
+    auto &n = nodes[i];
+    if (n.op == Z3_OP_UNINTERPRETED) {
+      auto &d = dom[find(n.var)];
+      if (!best || size(d) < size(*best) ||
+          (size(d) == size(*best) && d.var < best->var))
+        best = &d;
+    }
+    todo.insert(todo.end(), n.args.begin(), n.args.end());
+  }
+  ENSURE(best);
+  return *best;
+}
+
+// Evaluates the formula with the current assignment. If it's undecided,
+// pushes the next variable to assign.
+// Returns 1 if the formula holds, -1 if it doesn't, and 0 otherwise.
+int ModelEnumerator::expand() {
+  eval();
+  auto &root = vals.back();
+  if (root.known) {
+    if (!root.v)
+      return -1;
+    buildModel();
+    return 1;
+  }
+
+  stack.push_back(pickVar());
+  return 0;
+}
+
+void ModelEnumerator::buildModel() {
+  auto m = Z3_mk_model(ctx());
+  model = Model(m);
+  for (unsigned i = 0, e = vars.size(); i != e; ++i) {
+    auto &v = assignment[find(i)];
+    if (!v)
+      continue;
+    auto bits = nodes[var_node[i]].bits;
+    expr val = bits == 0 ? expr(*v != 0) : expr::mkUInt(*v, bits);
+    Z3_add_const_interp(ctx(), m, vars[i].decl(), val());
+  }
+}
+
+bool ModelEnumerator::next() {
+  if (!supported || done)
+    return false;
+
+  if (!started) {
+    started = true;
+    if (int r = expand()) {
+      // the formula doesn't depend on any variable
+      done = true;
+      return r > 0;
+    }
+  }
+
+  while (!stack.empty()) {
+    auto &f = stack.back();
+    if (f.next > f.last) {
+      assignment[f.var].reset();
+      stack.pop_back();
+      continue;
+    }
+    assignment[f.var] = f.next++;
+    if (expand() > 0)
+      return true;
+  }
+  done = true;
+  return false;
+}
+
+}
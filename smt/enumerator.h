@@ -0,0 +1,82 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "smt/expr.h"
+#include "smt/solver.h"
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+typedef struct _Z3_ast* Z3_ast;
+
+namespace smt {
+
+/// Enumerates the models of a formula over booleans and small bit-vector
+/// variables (up to 16 bits; up to 64 for intermediate terms) without
+/// calling the solver.
+/// Variables equated at the top level are unified upfront. The remaining
+/// ones are assigned in a depth-first search that evaluates the formula in
+/// 3-valued logic after each assignment to prune the search space; the
+/// values tried for a variable are limited by the bounds the formula puts
+/// on it. A variable the formula no longer depends on is left unassigned,
+/// so each model is only as specific as needed, like Solver::block() with
+/// variable discarding does.
+class ModelEnumerator {
+  struct Node {
+    int op;
+    unsigned bits; // 0 for booleans
+    uint64_t val = 0; // numerals
+    unsigned var = 0; // variables
+    unsigned lo = 0, hi = 0; // extract
+    std::vector<unsigned> args;
+  };
+
+  struct Val {
+    bool known = false;
+    uint64_t v = 0;
+  };
+
+  // the variable being assigned and its remaining domain [next, last]
+  struct Frame {
+    unsigned var;
+    uint64_t next, last;
+  };
+
+  std::vector<Node> nodes; // in topological order; the root is the last one
+  std::vector<expr> vars;
+  std::vector<unsigned> var_node;
+  std::vector<unsigned> rep; // unified variables point to their representative
+  std::vector<std::optional<uint64_t>> assignment; // indexed by representative
+  std::vector<Val> vals; // of each node, for the current assignment
+  std::vector<Frame> stack;
+  Model model;
+  bool supported = true;
+  bool started = false;
+  bool done = false;
+
+  unsigned compile(Z3_ast ast, std::unordered_map<Z3_ast, unsigned> &map);
+  void unify(unsigned node);
+  unsigned find(unsigned var) const;
+  void eval();
+  void bounds(std::vector<Frame> &dom) const;
+  Frame pickVar() const;
+  int expand();
+  void buildModel();
+
+public:
+  ModelEnumerator(const expr &e);
+
+  // false if the formula uses operations this enumerator can't evaluate
+  bool isSupported() const { return supported; }
+
+  // advances to the next model; returns false once there are no more
+  bool next();
+
+  // only valid after next() returns true
+  const Model& getModel() const { return model; }
+};
+
+}
@@ -411,6 +411,7 @@ public:
   friend class Solver;
   friend class FnModel;
   friend class Model;
+  friend class ModelEnumerator;
 };
 
 
@@ -5,6 +5,7 @@
 #include "smt/ctx.h"
 #include "smt/solver.h"
 #include "util/version.h"
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <z3.h>
@@ -14,6 +15,8 @@ using namespace std;
 
 namespace smt {
 
+static uint64_t peak_alloc_size = 0;
+
 smt_initializer::smt_initializer() {
   init();
 }
@@ -22,6 +25,7 @@ void smt_initializer::reset() {
   destroy();
   Z3_reset_memory();
   init();
+  peak_alloc_size = 0;
 }
 
 smt_initializer::~smt_initializer() {
@@ -66,12 +70,30 @@ void set_memory_limit(uint64_t limit) {
   z3_memory_limit = limit;
 }
 
+uint64_t get_memory_limit() {
+  return z3_memory_limit;
+}
+
+static uint64_t alloc_size() {
+  uint64_t size = Z3_get_estimated_alloc_size();
+  peak_alloc_size = max(peak_alloc_size, size);
+  return size;
+}
+
 bool hit_memory_limit() {
-  return Z3_get_estimated_alloc_size() >= z3_memory_limit;
+  return alloc_size() >= z3_memory_limit;
 }
 
 bool hit_half_memory_limit() {
-  return Z3_get_estimated_alloc_size() >= (z3_memory_limit / 2);
+  return alloc_size() >= (z3_memory_limit / 2);
+}
+
+uint64_t peak_memory_usage() {
+  return peak_alloc_size;
+}
+
+void update_peak_memory_usage() {
+  alloc_size();
 }
 
 void start_logging(const char *path) {
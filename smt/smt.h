@@ -25,8 +25,12 @@ void set_random_seed(std::string seed);
 const char *get_random_seed();
 
 void set_memory_limit(uint64_t limit);
+uint64_t get_memory_limit();
 bool hit_memory_limit();
 bool hit_half_memory_limit();
+// highest Z3 memory usage observed since the last reset, in bytes
+uint64_t peak_memory_usage();
+void update_peak_memory_usage();
 
 void start_logging(const char *path = "z3_log.txt");
 
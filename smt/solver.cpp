@@ -3,14 +3,18 @@
 
 #include "smt/solver.h"
 #include "smt/ctx.h"
+#include "smt/smt.h"
 #include "util/compiler.h"
 #include "util/config.h"
 #include "util/file.h"
+#include "util/stopwatch.h"
 #include <cassert>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <optional>
+#include <set>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -31,6 +35,8 @@ static unsigned num_sats = 0;
 static unsigned num_unsats = 0;
 static unsigned num_timeout = 0;
 static unsigned num_errors = 0;
+static double solver_time = 0;
+static set<string> *query_log = nullptr;
 
 namespace {
 
@@ -467,6 +473,11 @@ expr Solver::assertions() const {
   return ret;
 }
 
+static void log_query(const char *query_name, const char *outcome) {
+  if (query_log)
+    query_log->emplace(string(query_name) + ':' + outcome);
+}
+
 Result Solver::check(const char *query_name, bool dont_skip) const {
   if (!valid) {
     ++num_invalid;
@@ -475,6 +486,7 @@ Result Solver::check(const char *query_name, bool dont_skip) const {
 
   if (is_unsat) {
     ++num_trivial;
+    log_query(query_name, "trivial");
     return Result::UNSAT;
   }
 
@@ -509,20 +521,30 @@ Result Solver::check(const char *query_name, bool dont_skip) const {
 
   tactic->check();
 
-  switch (Z3_solver_check(ctx(), s)) {
+  StopWatch sw;
+  auto res = Z3_solver_check(ctx(), s);
+  sw.stop();
+  solver_time += sw.seconds();
+  update_peak_memory_usage();
+
+  switch (res) {
   case Z3_L_FALSE:
     ++num_unsats;
+    log_query(query_name, "unsat");
     return Result::UNSAT;
   case Z3_L_TRUE:
     ++num_sats;
+    log_query(query_name, "sat");
     return Z3_solver_get_model(ctx(), s);
   case Z3_L_UNDEF: {
     string_view reason = Z3_solver_get_reason_unknown(ctx(), s);
     if (reason == "timeout") {
       ++num_timeout;
+      log_query(query_name, "timeout");
       return Result::TIMEOUT;
     }
     ++num_errors;
+    log_query(query_name, "error");
     return { Result::ERROR, string(reason) };
   }
   default:
@@ -548,6 +570,18 @@ SolverPush::~SolverPush() {
 }
 
 
+unsigned solver_num_queries() {
+  return num_queries;
+}
+
+double solver_total_time() {
+  return solver_time;
+}
+
+void solver_log_queries(set<string> *log) {
+  query_log = log;
+}
+
 void solver_print_stats(ostream &os) {
   float total = num_queries / 100.0;
   float trivial_pc = num_queries == 0 ? 0 :
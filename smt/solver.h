@@ -6,6 +6,7 @@
 #include "smt/expr.h"
 #include <cassert>
 #include <ostream>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -25,6 +26,7 @@ class Model {
   ~Model();
 
   friend class Result;
+  friend class ModelEnumerator;
 
 public:
   Model(Model &&other) noexcept {
@@ -183,6 +185,12 @@ public:
 void solver_print_queries(bool yes);
 void solver_tactic_verbose(bool yes);
 void solver_print_stats(std::ostream &os);
+unsigned solver_num_queries();
+// seconds spent in the SMT solver so far
+double solver_total_time();
+// record the name and outcome of every subsequent query, e.g.
+// "memory:sat", into log (null to stop)
+void solver_log_queries(std::set<std::string> *log);
 
 
 struct EnableSMTQueriesTMP {
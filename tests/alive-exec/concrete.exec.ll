@@ -0,0 +1,38 @@
+; CHECK: Returned #x00000037
+; CHECK: Returned #x00000050
+; CHECK-NOT: Concrete execution not supported
+
+define i32 @loop() {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+  %i.next = add i32 %i, 1
+  %sum.next = add i32 %sum, %i.next
+  %c = icmp ult i32 %i.next, 10
+  br i1 %c, label %loop, label %exit
+
+exit:
+  ret i32 %sum.next
+}
+
+define i32 @diamond() {
+entry:
+  %a = mul i32 6, 7
+  %c = icmp sgt i32 %a, 40
+  br i1 %c, label %then, label %else
+
+then:
+  %t = sub i32 %a, 2
+  br label %exit
+
+else:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %t, %then ], [ 0, %else ]
+  %s = shl i32 %r, 1
+  ret i32 %s
+}
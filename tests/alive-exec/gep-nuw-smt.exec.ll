@@ -0,0 +1,12 @@
+; TEST-ARGS: -smt-exec
+; The index of a nuw gep is zero-extended, so a negative one gives poison
+; CHECK: / false
+; CHECK-NOT: Concrete execution
+
+define i1 @main() {
+  %p = alloca [4 x i8], align 1
+  %q = getelementptr inbounds i8, ptr %p, i64 2
+  %r = getelementptr inbounds nuw i8, ptr %q, i32 -1
+  %c = icmp eq ptr %r, %q
+  ret i1 %c
+}
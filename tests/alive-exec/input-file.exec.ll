@@ -0,0 +1,21 @@
+; TEST-ARGS: -input-file=%S/input-file.csv
+; CHECK: #x0000002a
+; CHECK: poison
+; CHECK: UB
+; CHECK: 'udiv' takes 2 arguments, but the input has 1
+; CHECK: Concrete execution of 'fadd' not supported
+; CHECK: #x00000056
+; CHECK: #x00000001
+
+define i32 @udiv(i32 %a, i32 %b) {
+  %r = udiv i32 %a, %b
+  ret i32 %r
+}
+
+define i32 @fadd(i32 %a, i32 %b) {
+  %x = sitofp i32 %a to float
+  %y = sitofp i32 %b to float
+  %s = fadd float %x, %y
+  %r = fptosi float %s to i32
+  ret i32 %r
+}
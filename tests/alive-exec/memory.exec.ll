@@ -0,0 +1,21 @@
+; CHECK: Returned #x0000002a
+; CHECK: %v = UB triggered!
+; CHECK-NOT: Concrete execution not supported
+
+define i32 @store_load() {
+  %p = alloca [4 x i32], align 4
+  %q = getelementptr inbounds [4 x i32], ptr %p, i64 0, i64 2
+  store i32 7, ptr %q, align 4
+  store i32 35, ptr %p, align 4
+  %a = load i32, ptr %q, align 4
+  %b = load i32, ptr %p, align 4
+  %s = add i32 %a, %b
+  ret i32 %s
+}
+
+define i32 @out_of_bounds() {
+  %p = alloca i32, align 4
+  %q = getelementptr i8, ptr %p, i64 4
+  %v = load i32, ptr %q, align 4
+  ret i32 %v
+}
@@ -0,0 +1,22 @@
+; TEST-ARGS: -smt-exec
+; CHECK: Returned #x00000050
+; CHECK-NOT: Concrete execution
+
+define i32 @diamond() {
+entry:
+  %a = mul i32 6, 7
+  %c = icmp sgt i32 %a, 40
+  br i1 %c, label %then, label %else
+
+then:
+  %t = sub i32 %a, 2
+  br label %exit
+
+else:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %t, %then ], [ 0, %else ]
+  %s = shl i32 %r, 1
+  ret i32 %s
+}
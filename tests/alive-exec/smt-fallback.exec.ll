@@ -0,0 +1,29 @@
+; The addresses of different blocks are not known concretely
+; CHECK: Concrete execution not supported (comparison of pointers to different blocks); using the SMT solver
+; CHECK: Returned #b0
+; Floats are rejected before running
+; CHECK: Concrete execution not supported (unsupported instruction: %r = fadd
+; CHECK: Returned #x00000003
+; Without inbounds, nuw depends on the address
+; CHECK: Concrete execution not supported (gep nuw without inbounds)
+
+define i1 @ptr_eq() {
+  %p = alloca i32, align 4
+  %q = alloca i32, align 4
+  %c = icmp eq ptr %p, %q
+  ret i1 %c
+}
+
+define i32 @fadd() {
+  %r = fadd float 1.000000e+00, 2.000000e+00
+  %i = fptosi float %r to i32
+  ret i32 %i
+}
+
+define i64 @gep_nuw() {
+  %p = alloca [4 x i8], align 1
+  %q = getelementptr nuw i8, ptr %p, i64 2
+  %v = load i8, ptr %q, align 1
+  %r = zext i8 %v to i64
+  ret i64 %r
+}
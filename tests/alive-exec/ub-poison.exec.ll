@@ -0,0 +1,14 @@
+; CHECK: %d = UB triggered!
+; CHECK: Returned poison
+; CHECK-NOT: Concrete execution not supported
+
+define i32 @div_by_zero() {
+  %z = sub i32 1, 1
+  %d = udiv i32 1, %z
+  ret i32 %d
+}
+
+define i8 @add_overflow() {
+  %r = add nsw i8 127, 1
+  ret i8 %r
+}
@@ -0,0 +1,15 @@
+; TEST-ARGS: -bidirectional
+; CHECK: These functions seem to be equivalent!
+
+@g = global i32 0
+
+define i32 @src() {
+  %a = load i32, ptr @g
+  %b = add i32 %a, 0
+  ret i32 %b
+}
+
+define i32 @tgt() {
+  %a = load i32, ptr @g
+  ret i32 %a
+}
@@ -0,0 +1,16 @@
+; TEST-ARGS: -bidirectional
+; CHECK: These functions seem to be equivalent!
+
+@g = global i32 0
+@h = global i32 0
+
+define i32 @src() {
+  %a = load i32, ptr @g
+  ret i32 %a
+}
+
+define i32 @tgt() {
+  %a = load i32, ptr @g
+  %b = load i32, ptr @h
+  ret i32 %a
+}
@@ -0,0 +1,12 @@
+; TEST-ARGS: -bidirectional
+; CHECK: Reverse transformation doesn't verify!
+
+define i8 @src(i8 %x) {
+  %a = add nsw i8 %x, 1
+  ret i8 %a
+}
+
+define i8 @tgt(i8 %x) {
+  %a = add i8 %x, 1
+  ret i8 %a
+}
@@ -0,0 +1,35 @@
+; The pointer returned by @g may point to any of the escaped locals %a, %b
+; and %d, but not %c. A set of aliased blocks with a gap, like {0,1,3}
+; here, must not be taken as {0,1}.
+
+declare void @esc(ptr, ptr, ptr)
+declare ptr @g()
+
+define i8 @src() {
+  %a = alloca i8
+  %b = alloca i8
+  %c = alloca i8
+  %d = alloca i8
+  store i8 0, ptr %c
+  call void @esc(ptr %a, ptr %b, ptr %d)
+  %p = call ptr @g()
+  store i8 1, ptr %d
+  store i8 2, ptr %p
+  %v = load i8, ptr %d
+  ret i8 %v
+}
+
+define i8 @tgt() {
+  %a = alloca i8
+  %b = alloca i8
+  %c = alloca i8
+  %d = alloca i8
+  store i8 0, ptr %c
+  call void @esc(ptr %a, ptr %b, ptr %d)
+  %p = call ptr @g()
+  store i8 1, ptr %d
+  store i8 2, ptr %p
+  ret i8 1
+}
+
+; ERROR: Value mismatch
@@ -0,0 +1,25 @@
+; TEST-ARGS: -j 2 -bidirectional
+
+define i8 @src_a(i8 %x) {
+  %a = add nsw i8 %x, 1
+  ret i8 %a
+}
+
+define i8 @tgt_a(i8 %x) {
+  %a = add i8 %x, 1
+  ret i8 %a
+}
+
+define i8 @src_b(i8 %x) {
+  %a = mul i8 %x, 2
+  ret i8 %a
+}
+
+define i8 @tgt_b(i8 %x) {
+  %a = shl i8 %x, 1
+  ret i8 %a
+}
+
+; CHECK: Reverse transformation doesn't verify!
+; CHECK: 1 correct transformations
+; CHECK: 1 incorrect transformations
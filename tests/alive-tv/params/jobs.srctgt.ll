@@ -0,0 +1,32 @@
+; TEST-ARGS: -j 2
+
+define i32 @src_a(i32 %x) {
+  %y = add i32 %x, 0
+  ret i32 %y
+}
+
+define i32 @tgt_a(i32 %x) {
+  ret i32 %x
+}
+
+define i32 @src_b(i32 %x) {
+  %y = mul i32 %x, 2
+  ret i32 %y
+}
+
+define i32 @tgt_b(i32 %x) {
+  %y = shl i32 %x, 1
+  ret i32 %y
+}
+
+define i32 @src_c(i32 %x) {
+  %y = sub i32 %x, %x
+  ret i32 %y
+}
+
+define i32 @tgt_c(i32 %x) {
+  ret i32 0
+}
+
+; CHECK: 3 correct transformations
+; CHECK: 0 incorrect transformations
@@ -0,0 +1,121 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+// Checks the results of the C API. Built and run by the check-capi target.
+
+#include "capi/alive2.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define EXPECT(cond)                                                          \
+  do {                                                                        \
+    if (!(cond)) {                                                            \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #cond);     \
+      ++failures;                                                             \
+    }                                                                         \
+  } while (0)
+
+static const char *correct_ir =
+  "define i32 @src(i32 %x) {\n"
+  "  %a = add i32 %x, 0\n"
+  "  ret i32 %a\n"
+  "}\n"
+  "define i32 @tgt(i32 %x) {\n"
+  "  ret i32 %x\n"
+  "}\n";
+
+static const char *unsound_ir =
+  "define i8 @src(i8 %x, i8 %y) {\n"
+  "  %a = add i8 %x, %y\n"
+  "  ret i8 %a\n"
+  "}\n"
+  "define i8 @tgt(i8 %x, i8 %y) {\n"
+  "  %a = sub i8 %x, %y\n"
+  "  ret i8 %a\n"
+  "}\n";
+
+static const char *two_fns_src =
+  "define i8 @f(i8 %x) {\n"
+  "  %a = mul i8 %x, 2\n"
+  "  ret i8 %a\n"
+  "}\n"
+  "define i8 @g(i8 %x) {\n"
+  "  ret i8 %x\n"
+  "}\n";
+
+static const char *two_fns_tgt =
+  "define i8 @f(i8 %x) {\n"
+  "  %a = shl i8 %x, 1\n"
+  "  ret i8 %a\n"
+  "}\n"
+  "define i8 @g(i8 %x) {\n"
+  "  ret i8 0\n"
+  "}\n";
+
+int main(void) {
+  alive2_session *s = alive2_session_create();
+  EXPECT(s);
+  if (!s)
+    return 1;
+  EXPECT(!alive2_session_create());
+
+  alive2_result *r = alive2_verify_ir(s, correct_ir, NULL, NULL, NULL);
+  EXPECT(alive2_result_status(r) == ALIVE2_CORRECT);
+  EXPECT(alive2_result_num_values(r) == 0);
+  EXPECT(strstr(alive2_result_report(r), "seems to be correct"));
+  alive2_result_destroy(r);
+
+  // one value per input, from a single counterexample
+  r = alive2_verify_ir(s, unsound_ir, NULL, NULL, NULL);
+  EXPECT(alive2_result_status(r) == ALIVE2_UNSOUND);
+  EXPECT(strstr(alive2_result_report(r), "Value mismatch"));
+  EXPECT(alive2_result_num_values(r) == 2);
+  if (alive2_result_num_values(r) == 2) {
+    EXPECT(!strcmp(alive2_result_value_name(r, 0), "%x"));
+    EXPECT(!strcmp(alive2_result_value_name(r, 1), "%y"));
+    EXPECT(*alive2_result_value(r, 0));
+    EXPECT(*alive2_result_value(r, 1));
+  }
+  alive2_result_destroy(r);
+
+  // only the function asked for is checked
+  alive2_limits limits = { 10000, 0, 0, 0 };
+  r = alive2_verify_ir(s, two_fns_src, two_fns_tgt, "f", &limits);
+  EXPECT(alive2_result_status(r) == ALIVE2_CORRECT);
+  alive2_result_destroy(r);
+
+  r = alive2_verify_ir(s, two_fns_src, two_fns_tgt, NULL, &limits);
+  EXPECT(alive2_result_status(r) == ALIVE2_UNSOUND);
+  EXPECT(alive2_result_num_values(r) == 1);
+  alive2_result_destroy(r);
+
+  r = alive2_verify_ir(s, "define i32 @src(", NULL, NULL, NULL);
+  EXPECT(alive2_result_status(r) == ALIVE2_ERROR);
+  EXPECT(strstr(alive2_result_report(r), "Could not parse src"));
+  alive2_result_destroy(r);
+
+  r = alive2_verify_ir(s, two_fns_src, NULL, NULL, NULL);
+  EXPECT(alive2_result_status(r) == ALIVE2_ERROR);
+  EXPECT(strstr(alive2_result_report(r), "Expected functions @src and @tgt"));
+  alive2_result_destroy(r);
+
+  r = alive2_verify_ir(s, two_fns_src, two_fns_tgt, "h", NULL);
+  EXPECT(alive2_result_status(r) == ALIVE2_ERROR);
+  EXPECT(strstr(alive2_result_report(r), "No functions to verify"));
+  alive2_result_destroy(r);
+
+  alive2_session_destroy(s);
+
+  // a new session can be created once the previous one is gone
+  s = alive2_session_create();
+  EXPECT(s);
+  alive2_session_destroy(s);
+
+  if (failures)
+    fprintf(stderr, "%d checks failed\n", failures);
+  else
+    printf("All C API checks passed\n");
+  return failures != 0;
+}
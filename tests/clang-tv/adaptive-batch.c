@@ -0,0 +1,15 @@
+// TEST-ARGS: -O2 -mllvm -tv-adaptive-batch
+
+int f(int x) {
+  return x + 1 - 1;
+}
+
+int g(int *x, int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i)
+    s += x[i];
+  return s;
+}
+
+// CHECK: Transformation seems to be correct!
+// CHECK-NOT: Transformation doesn't verify!
@@ -0,0 +1,8 @@
+// TEST-ARGS: -O2 -mllvm -tv-resource-stats -mllvm -tv-parallel=unrestricted -mllvm --max-subprocesses=2
+
+int f(int *x, int *y) {
+  return *x + *y;
+}
+
+// CHECK: Z3 peak memory:
+// CHECK: Process resource usage: user
@@ -0,0 +1,15 @@
+// TEST-ARGS: -O2 -mllvm -tv-parallel=unrestricted -mllvm --max-subprocesses=2 -mllvm -tv-schedule=longest-first -mllvm -tv-resource-stats
+
+int f(int x) {
+  return x + 1 - 1;
+}
+
+int g(int *x, int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i)
+    s += x[i];
+  return s;
+}
+
+// CHECK: Estimated cost:
+// CHECK: Transformation seems to be correct!
@@ -0,0 +1,11 @@
+// TEST-ARGS: -O2 -mllvm -tv-parallel=unrestricted -mllvm -tv-parallel-max-buffer=0
+
+int f(int x) {
+  return x + 1 - 1;
+}
+
+int g(int *x, int *y) {
+  return *x + *y;
+}
+
+// CHECK: Transformation seems to be correct!
@@ -0,0 +1,9 @@
+// TEST-ARGS: -O2 -mllvm -tv-pass-profile
+
+int f(int x) {
+  return x + 1 - 1;
+}
+
+// CHECK: === Verification cost per pass ===
+// CHECK: llvm2alive
+// CHECK: InstCombinePass
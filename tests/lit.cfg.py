@@ -4,3 +4,5 @@ import lit.formats
 config.name = 'Alive2'
 config.test_format = lit.formats.Alive2Test()
 config.test_source_root = os.path.dirname(__file__)
+# built and run by the check-capi target
+config.excludes = ['capi']
@@ -4,7 +4,7 @@
 import lit.TestRunner
 import lit.util
 from .base import TestFormat
-import os, re
+import os, re, shutil, tempfile
 
 ok_string = 'Transformation seems to be correct!'
 
@@ -47,7 +47,8 @@ class Alive2Test(TestFormat):
           (filename.endswith('.opt') or filename.endswith('.src.ll') or
            filename.endswith('.srctgt.ll') or filename.endswith('.c') or
            filename.endswith('.cpp') or filename.endswith('.opt.ll') or
-           filename.endswith('.ident.ll')):
+           filename.endswith('.ident.ll') or filename.endswith('.serve') or
+           filename.endswith('.exec.ll') or filename.endswith('.fuzz')):
         yield lit.Test.Test(testSuite, path_in_suite + (filename,), localConfig)
 
 
@@ -62,6 +63,24 @@ class Alive2Test(TestFormat):
       if not os.path.isfile('alive-tv'):
         return lit.Test.UNSUPPORTED, ''
 
+    serve = test.endswith('.serve')
+    if serve:
+      cmd = ['./alive-tv', '--serve']
+      if not os.path.isfile('alive-tv'):
+        return lit.Test.UNSUPPORTED, ''
+
+    alive_exec = test.endswith('.exec.ll')
+    if alive_exec:
+      cmd = ['./alive-exec']
+      if not os.path.isfile('alive-exec'):
+        return lit.Test.UNSUPPORTED, ''
+
+    fuzz = test.endswith('.fuzz')
+    if fuzz:
+      cmd = ['./quick-fuzz']
+      if not os.path.isfile('quick-fuzz'):
+        return lit.Test.UNSUPPORTED, ''
+
     opt_tv = test.endswith('.opt.ll')
     if opt_tv:
       cmd = ['./opt-alive-test.sh', '-disable-output', '-tv-always-verify']
@@ -78,15 +97,21 @@ class Alive2Test(TestFormat):
         return lit.Test.UNSUPPORTED, ''
 
     if not alive_tv_1 and not alive_tv_2 and not alive_tv_3 and \
-       not clang_tv and not opt_tv:
+       not clang_tv and not opt_tv and not serve and not alive_exec and \
+       not fuzz:
       cmd = ['./alive', '-smt-to:20000']
 
     input = readFile(test)
 
     # add test-specific args
     m = self.regex_args.search(input)
+    tmpdir = None
     if m != None:
-      cmd += m.group(1).split()
+      args = m.group(1).replace('%S', os.path.dirname(test))
+      if '%t' in args:
+        tmpdir = tempfile.mkdtemp()
+        args = args.replace('%t', tmpdir)
+      cmd += args.split()
 
     do_identity = self.regex_skip_identity.search(input) is None
 
@@ -106,13 +131,23 @@ class Alive2Test(TestFormat):
       except Exception as e:
         return lit.Test.FAIL, e
 
-    cmd.append(test)
+    # the requests are the lines that aren't test directives
+    stdin = None
+    if serve:
+      stdin = ''.join(l for l in input.splitlines(True)
+                      if not l.startswith(';'))
+    elif not fuzz:
+      cmd.append(test)
     if alive_tv_2:
       cmd.append(test.replace('.src.ll', '.tgt.ll'))
     elif alive_tv_3:
       cmd.append(test)
 
-    out, err, exitCode = lit.util.executeCommand(cmd)
+    try:
+      out, err, exitCode = lit.util.executeCommand(cmd, input=stdin)
+    finally:
+      if tmpdir:
+        shutil.rmtree(tmpdir)
     output = out + err
 
     xfail = self.regex_xfail.search(input)
@@ -0,0 +1,26 @@
+; TEST-ARGS: -passes=sroa,instsimplify,early-cse,instcombine,simplifycfg,dce,instsimplify -tv-adaptive-batch
+; The window with instcombine fails (printf -> puts can't be proved); the
+; passes after it in the same window must still be verified.
+
+@.str = constant [3 x i8] c"a\0A\00", align 1
+
+define i32 @f(i32 %y) {
+entry:
+  %p = alloca i32
+  store i32 %y, i32* %p
+  %v = load i32, i32* %p
+  %a = add i32 %v, 0
+  %b1 = mul i32 %a, 3
+  %b2 = mul i32 %a, 3
+  %c = add i32 %b1, %b2
+  call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @.str, i64 0, i64 0))
+  br label %exit
+
+exit:
+  ret i32 %c
+}
+
+declare i32 @printf(i8*, ...)
+
+; CHECK: Couldn't prove the correctness of the transformation
+; CHECK: Transformation seems to be correct! (batch of 3 passes)
@@ -0,0 +1,10 @@
+; TEST-ARGS: -passes=instsimplify,sroa
+
+define i32 @f(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
+
+; CHECK: Transformation seems to be correct!
+; CHECK: Transformation seems to be correct! (syntactically equal)
+; CHECK-NOT: Transformation doesn't verify!
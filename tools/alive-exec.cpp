@@ -6,6 +6,7 @@
 #include "llvm_util/utils.h"
 #include "smt/smt.h"
 #include "smt/solver.h"
+#include "tools/interpreter.h"
 #include "tools/transform.h"
 #include "util/symexec.h"
 #include "util/version.h"
@@ -20,8 +21,11 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/TargetParser/Triple.h"
 
+#include <cerrno>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <utility>
 
 using namespace IR;
@@ -40,32 +44,59 @@ llvm::cl::opt<string> opt_file(llvm::cl::Positional,
   llvm::cl::desc("bitcode_file"), llvm::cl::Required,
   llvm::cl::value_desc("filename"), llvm::cl::cat(alive_cmdargs));
 
+llvm::cl::opt<bool> opt_smt_exec("smt-exec",
+  llvm::cl::desc("Always execute using the SMT solver instead of the concrete "
+                 "interpreter (default=false)"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<string> opt_input_file("input-file",
+  llvm::cl::desc("Run the functions once per line of the given CSV file, "
+                 "using each line as the list of arguments (integers, "
+                 "'poison', or 'undef'), and print one result per line"),
+  llvm::cl::value_desc("filename"), llvm::cl::cat(alive_cmdargs));
+
 StateValue eval(const Result &r, const StateValue &v) {
   auto &m = r.getModel();
   return { m[v.value], m[v.non_poison] };
 }
 
-optional<StateValue> exec(llvm::Function &F,
-                          llvm::TargetLibraryInfoWrapperPass &TLI) {
-  auto Func = llvm2alive(F, TLI.getTLI(F), true);
-  if (!Func) {
-    cerr << "ERROR: Could not translate '" << F.getName().str()
-         << "' to Alive IR\n";
-    return {};
-  }
+struct ExecResult {
+  enum Status { Returned, UB, Error } status = Error;
+  string value; // the returned value, or the instruction triggering UB
+  int64_t exit_code = 0;
+};
+
+int64_t to_exit_code(const ConcreteVal &v, const Type &ty) {
+  if (v.is_ptr || v.poison || !ty.isIntType())
+    return 0;
+  unsigned bits = ty.bits();
+  return bits >= 64 ? (int64_t)v.bits
+                    : (int64_t)(v.bits << (64 - bits)) >> (64 - bits);
+}
 
-  if (!config::quiet)
-    Func->print(cout << "\n----------------------------------------\n");
+// Returns false if the function couldn't be interpreted concretely.
+bool exec_concrete(const Interpreter &interp, const Function &Func,
+                   const Interpreter::Result &r, ExecResult &res) {
+  if (r.status == Interpreter::Unsupported)
+    return false;
 
-  {
-    TypingAssignments types{Func->getTypeConstraints()};
-    if (!types) {
-      cerr << "Internal ERROR: program doesn't type check!\n\n";
-      return {};
-    }
-    assert(types.hasSingleTyping());
+  if (r.status == Interpreter::UB) {
+    res.status = ExecResult::UB;
+    res.value  = r.msg;
+    return true;
   }
 
+  ostringstream os;
+  interp.print(os, r.val, Func.getType());
+  res.status    = ExecResult::Returned;
+  res.value     = std::move(os).str();
+  res.exit_code = to_exit_code(r.val, Func.getType());
+  return true;
+}
+
+ExecResult exec_smt(const Function &Func, const vector<ConcreteVal> *args,
+                    bool verbose) {
+  ExecResult res;
   auto error = [&](const Result &r) {
     if (r.isSat() || r.isUnsat())
       return false;
@@ -85,21 +116,37 @@ optional<StateValue> exec(llvm::Function &F,
   };
 
   try {
-    State state(*Func, true);
+    State state(Func, true);
     sym_exec_init(state);
 
-    const BasicBlock *curr_bb = &Func->getFirstBB();
+    const BasicBlock *curr_bb = &Func.getFirstBB();
 
     // #init block has been executed already by sym_exec_init
     if (curr_bb->getName() == "#init") {
-      curr_bb = &Func->getBB(1);
+      curr_bb = Func.getBBs()[1];
     }
     state.startBB(*curr_bb);
 
     auto It = curr_bb->instrs().begin();
     Solver solver(true);
 
-    if (!config::quiet)
+    // pin the arguments to the given values; the others remain free
+    if (args) {
+      unsigned argn = 0;
+      for (auto &in : Func.getInputs()) {
+        if (argn >= args->size())
+          break;
+        auto &arg = (*args)[argn++];
+        auto &sv = state[in];
+        if (arg.poison)
+          solver.add(!sv.non_poison);
+        else if (!arg.undef)
+          solver.add(sv.value ==
+                       expr::mkUInt(arg.bits, 64).zextOrTrunc(sv.bits()));
+      }
+    }
+
+    if (verbose)
       cout << "Executing " << curr_bb->getName() << '\n';
 
     while (true) {
@@ -115,14 +162,23 @@ optional<StateValue> exec(llvm::Function &F,
       solver.add(val.return_domain);
       auto r = solver.check("return domain");
       if (error(r))
-        return {};
+        return res;
 
       if (dynamic_cast<const Return*>(&next_instr)) {
         assert(r.isSat());
         auto ret = eval(r, state.returnVal().val);
-        if (!config::quiet)
+        if (verbose)
           cout << "Returned " << ret << '\n';
-        return ret;
+
+        ostringstream os;
+        if (ret.non_poison.isFalse())
+          os << "poison";
+        else
+          os << ret.value;
+        res.status = ExecResult::Returned;
+        res.value  = std::move(os).str();
+        ret.value.isInt(res.exit_code);
+        return res;
       }
 
       if (auto *jmp = dynamic_cast<const JumpInstr*>(&next_instr)) {
@@ -134,10 +190,10 @@ optional<StateValue> exec(llvm::Function &F,
             solver.add(cond);
             auto r = solver.check("jump condition");
             if (error(r))
-              return {};
+              return res;
 
             if (r.isSat()) {
-              if (!config::quiet)
+              if (verbose)
                 cout << "  >> Jump to " << dst.getName() << "\n\n";
               curr_bb = &dst;
               state.startBB(dst);
@@ -150,7 +206,7 @@ optional<StateValue> exec(llvm::Function &F,
           solver.add(cond);
           if (!jumped) {
             cerr << "ERROR: All jump destinations are unreachable!\n\n";
-            return {};
+            return res;
           }
         }
         continue;
@@ -159,14 +215,15 @@ optional<StateValue> exec(llvm::Function &F,
       solver.add(val.domain());
       r = solver.check("domain");
       if (error(r))
-        return {};
+        return res;
 
       if (r.isUnsat()) {
-        cout << name << " = UB triggered!\n\n";
-        return {};
+        res.status = ExecResult::UB;
+        res.value  = name;
+        return res;
       }
 
-      if (!config::quiet) {
+      if (verbose) {
         cout << name;
         if (name[0] == '%') {
           auto v = eval(r, val.val);
@@ -183,10 +240,157 @@ optional<StateValue> exec(llvm::Function &F,
     }
   } catch (const AliveException &e) {
     cout << "ERROR: " << e.msg << '\n';
-    return {};
+    return res;
   }
   UNREACHABLE();
 }
+
+optional<Function> translate(llvm::Function &F,
+                             llvm::TargetLibraryInfoWrapperPass &TLI) {
+  auto Func = llvm2alive(F, TLI.getTLI(F), true);
+  if (!Func) {
+    cerr << "ERROR: Could not translate '" << F.getName().str()
+         << "' to Alive IR\n";
+    return {};
+  }
+
+  if (!config::quiet && opt_input_file.empty())
+    Func->print(cout << "\n----------------------------------------\n");
+
+  TypingAssignments types{Func->getTypeConstraints()};
+  if (!types) {
+    cerr << "Internal ERROR: program doesn't type check!\n\n";
+    return {};
+  }
+  assert(types.hasSingleTyping());
+  return Func;
+}
+
+optional<int64_t> exec(llvm::Function &F,
+                       llvm::TargetLibraryInfoWrapperPass &TLI) {
+  auto Func = translate(F, TLI);
+  if (!Func)
+    return {};
+
+  ExecResult res;
+  bool done = false;
+  if (!opt_smt_exec) {
+    Interpreter interp(*Func);
+    ostringstream trace;
+    auto r = interp.run({}, config::quiet ? nullptr : &trace);
+    done = exec_concrete(interp, *Func, r, res);
+
+    if (!done) {
+      if (!config::quiet)
+        cout << "Concrete execution not supported (" << r.msg
+             << "); using the SMT solver\n";
+    } else {
+      cout << std::move(trace).str();
+      if (!config::quiet && res.status == ExecResult::Returned) {
+        cout << "Returned ";
+        interp.print(cout, r.val, Func->getType());
+        cout << '\n';
+      }
+    }
+  }
+
+  if (!done)
+    res = exec_smt(*Func, nullptr, !config::quiet);
+
+  if (res.status == ExecResult::UB)
+    cout << res.value << " = UB triggered!\n\n";
+  if (res.status != ExecResult::Returned)
+    return {};
+  return res.exit_code;
+}
+
+bool parse_inputs(istream &is, vector<vector<ConcreteVal>> &inputs) {
+  string line;
+  unsigned lineno = 0;
+  while (getline(is, line)) {
+    ++lineno;
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    auto &args = inputs.emplace_back();
+    istringstream ls(line);
+    string tok;
+    while (getline(ls, tok, ',')) {
+      auto b = tok.find_first_not_of(" \t\r");
+      auto e = tok.find_last_not_of(" \t\r");
+      tok = b == string::npos ? "" : tok.substr(b, e - b + 1);
+
+      if (tok == "poison") {
+        args.emplace_back(ConcreteVal::mkPoison(false));
+        continue;
+      }
+      if (tok == "undef") {
+        args.emplace_back(ConcreteVal::mkUndef(false));
+        continue;
+      }
+
+      char *end = nullptr;
+      errno = 0;
+      uint64_t n = tok[0] == '-' ? (uint64_t)strtoll(tok.c_str(), &end, 0)
+                                 : strtoull(tok.c_str(), &end, 0);
+      if (tok.empty() || errno || *end) {
+        cerr << "ERROR: " << opt_input_file << ':' << lineno
+             << ": invalid argument '" << tok << "'\n";
+        return false;
+      }
+      args.emplace_back(ConcreteVal::mkInt(n));
+    }
+  }
+  return true;
+}
+
+// Runs the function once per input. Translation, type checking, and the
+// interpreter setup are done only once.
+bool exec_batch(llvm::Function &F, llvm::TargetLibraryInfoWrapperPass &TLI,
+                const vector<vector<ConcreteVal>> &inputs) {
+  auto Func = translate(F, TLI);
+  if (!Func)
+    return false;
+
+  Interpreter interp(*Func);
+  bool concrete = !opt_smt_exec && interp.unsupported().empty();
+  if (!concrete && !opt_smt_exec && !config::quiet)
+    cerr << "Concrete execution of '" << F.getName().str()
+         << "' not supported (" << interp.unsupported()
+         << "); using the SMT solver\n";
+
+  bool ok = true;
+  for (auto &args : inputs) {
+    // the engines don't agree on the value of missing arguments
+    if (args.size() != F.arg_size()) {
+      cerr << "ERROR: '" << F.getName().str() << "' takes " << F.arg_size()
+           << " arguments, but the input has " << args.size() << '\n';
+      cout << "ERROR\n";
+      ok = false;
+      continue;
+    }
+
+    ExecResult res;
+    if (!concrete || !exec_concrete(interp, *Func, interp.run(args), res)) {
+      State::resetGlobals();
+      res = exec_smt(*Func, &args, false);
+    }
+
+    switch (res.status) {
+    case ExecResult::Returned:
+      cout << res.value << '\n';
+      break;
+    case ExecResult::UB:
+      cout << "UB\n";
+      break;
+    case ExecResult::Error:
+      cout << "ERROR\n";
+      ok = false;
+      break;
+    }
+  }
+  return ok;
+}
 }
 
 unique_ptr<Cache> cache;
@@ -214,6 +418,11 @@ execute them using Alive2 as an interpreter.
 If no functions are specified on the command line, then alive-exec
 will attempt to execute the 'main' function.
 If it doesn't exist, alive-exec executes every function in the bitcode file.
+
+With --input-file, each function is executed once per line of the given CSV
+file, with the line's values as arguments, and a single line is printed per
+execution: the returned value, "poison", or "UB". Lines must have one value
+per argument of the function; "ERROR" is printed for those that don't.
 )EOF";
 
   llvm::cl::HideUnrelatedOptions(alive_cmdargs);
@@ -235,12 +444,29 @@ If it doesn't exist, alive-exec executes every function in the bitcode file.
   llvm_util::initializer llvm_util_init(cerr, DL);
   smt::smt_initializer smt_init;
 
+  vector<vector<ConcreteVal>> inputs;
+  if (!opt_input_file.empty()) {
+    ifstream is(opt_input_file);
+    if (!is) {
+      cerr << "Could not read inputs from '" << opt_input_file << "'\n";
+      return -1;
+    }
+    if (!parse_inputs(is, inputs))
+      return -1;
+  }
+
+  auto run = [&](llvm::Function &F) -> optional<int64_t> {
+    if (opt_input_file.empty())
+      return exec(F, TLI);
+    return exec_batch(F, TLI, inputs) ? optional<int64_t>(0) : nullopt;
+  };
+
   auto *main_fn = findFunction(*M, "main");
-  optional<StateValue> ret_val;
+  optional<int64_t> ret_val;
 
   if (main_fn && func_names.empty()) {
     State::resetGlobals();
-    ret_val = exec(*main_fn, TLI);
+    ret_val = run(*main_fn);
   } else {
     for (auto &F : *M) {
       if (F.isDeclaration())
@@ -249,15 +475,9 @@ If it doesn't exist, alive-exec executes every function in the bitcode file.
         continue;
       State::resetGlobals();
       smt_init.reset();
-      ret_val = exec(F, TLI);
+      ret_val = run(F);
     }
   }
 
-  if (ret_val) {
-    int64_t n = 0;
-    ret_val->value.isInt(n);
-    return (int)n;
-  } else {
-    return -1;
-  }
+  return ret_val ? (int)*ret_val : -1;
 }
@@ -8,8 +8,11 @@
 #include "llvm_util/utils.h"
 #include "smt/smt.h"
 #include "tools/transform.h"
+#include "util/compiler.h"
+#include "util/parallel.h"
 #include "util/version.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/InitializePasses.h"
@@ -21,13 +24,24 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/TargetParser/Triple.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
+#include <cerrno>
+#include <csignal>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <utility>
 
 using namespace tools;
@@ -44,7 +58,7 @@ namespace {
 
 llvm::cl::opt<string> opt_file1(llvm::cl::Positional,
   llvm::cl::desc("first_bitcode_file"),
-  llvm::cl::Required, llvm::cl::value_desc("filename"),
+  llvm::cl::Optional, llvm::cl::value_desc("filename"),
   llvm::cl::cat(alive_cmdargs));
 
 llvm::cl::opt<string> opt_file2(llvm::cl::Positional,
@@ -68,6 +82,330 @@ llvm::cl::opt<string>
                            "https://llvm.org/docs/NewPassManager.html#invoking-opt"),
             llvm::cl::cat(alive_cmdargs), llvm::cl::init("O2"));
 
+llvm::cl::opt<string> opt_serve(LLVM_ARGS_PREFIX "serve",
+  llvm::cl::desc("Verify requests given as JSON lines on stdin, or on "
+                 "connections to the given UNIX socket, in a single process"),
+  llvm::cl::ValueOptional, llvm::cl::value_desc("socket"),
+  llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<unsigned> opt_jobs(LLVM_ARGS_PREFIX "j",
+  llvm::cl::desc("Number of function pairs to verify in parallel "
+                 "(default=1)"),
+  llvm::cl::Prefix, llvm::cl::value_desc("N"),
+  llvm::cl::cat(alive_cmdargs), llvm::cl::init(1));
+
+// Exit codes used by a child process to report its verdict to the parent
+enum ChildResult { CHILD_CORRECT, CHILD_UNSOUND, CHILD_FAILED, CHILD_ERROR };
+
+// ok is what compareFunctions returned; it's false also when the reverse
+// check of -bidirectional fails, which doesn't bump any counter
+ChildResult childResult(const Verifier &v, bool ok) {
+  if (v.num_unsound || !ok)
+    return CHILD_UNSOUND;
+  if (v.num_failed)
+    return CHILD_FAILED;
+  if (v.num_errors)
+    return CHILD_ERROR;
+  return CHILD_CORRECT;
+}
+
+// Verifies the src/tgt function pairs of M: "src" against "tgt", "src4"
+// against "tgt4", "src_foo" against "tgt_foo", and so on. Returns the number
+// of pairs found; stops early, setting stopped, if compare returns false.
+template <typename Fn>
+unsigned compareSrcTgtPairs(llvm::Module &M, const string &src_fn,
+                            const string &tgt_fn, Fn &&compare,
+                            bool &stopped) {
+  unsigned Cnt = 0;
+  for (auto &F1 : M) {
+    if (F1.isDeclaration())
+      continue;
+    auto SrcFName = F1.getName();
+    if (!SrcFName.starts_with(src_fn))
+      continue;
+
+    // Check src{+d}/tgt{+d} variant
+    if (std::find_if(SrcFName.begin() + src_fn.length(), SrcFName.end(),
+                     [](unsigned char c) { return !std::isdigit(c); }) ==
+        SrcFName.end()) {
+      // Pass, we found a valid postfix
+    }
+    // Check src_*/tgt_* variant
+    else if (SrcFName.str().length() > src_fn.length() &&
+             SrcFName[src_fn.length()] == '_') {
+      // Pass, we found a valid postfix
+    }
+    // No valid postfix.
+    else {
+      continue;
+    }
+
+    // Check if we have tgt + same postfix
+    auto DstFName = SrcFName.str().replace(0, src_fn.length(), tgt_fn);
+    auto SRC = findFunction(M, SrcFName.str());
+    auto TGT = findFunction(M, DstFName);
+    if (SRC && TGT) {
+      ++Cnt;
+      if (!compare(*SRC, *TGT)) {
+        stopped = true;
+        break;
+      }
+    }
+  }
+  return Cnt;
+}
+
+// Verifies the functions of M1 against the ones with the same name in M2.
+// Returns false if compare asked to stop.
+template <typename Fn>
+bool compareModules(llvm::Module &M1, llvm::Module &M2, Fn &&compare) {
+  // Index tgt functions by name; anonymous functions are matched by
+  // their position among the anonymous functions of each module
+  llvm::StringMap<llvm::Function*> M2_fns;
+  vector<llvm::Function*> M2_anon_fns;
+  for (auto &F2 : M2) {
+    if (F2.isDeclaration())
+      continue;
+    if (F2.getName().empty())
+      M2_anon_fns.emplace_back(&F2);
+    else
+      M2_fns.try_emplace(F2.getName(), &F2);
+  }
+
+  unsigned M1_anon_count = 0;
+  for (auto &F1 : M1) {
+    if (F1.isDeclaration())
+      continue;
+    if (F1.getName().empty())
+      M1_anon_count++;
+    if (!func_names.empty() && !func_names.count(F1.getName().str()))
+      continue;
+
+    llvm::Function *F2 = nullptr;
+    if (F1.getName().empty()) {
+      if (M1_anon_count <= M2_anon_fns.size())
+        F2 = M2_anon_fns[M1_anon_count - 1];
+    } else if (auto I = M2_fns.find(F1.getName()); I != M2_fns.end()) {
+      F2 = I->second;
+    }
+
+    if (F2 && !compare(F1, *F2))
+      return false;
+  }
+  return true;
+}
+
+
+/*
+ * Server mode, for harnesses that would otherwise start a process per test.
+ * Each request is a JSON object on its own line, e.g.:
+ *   {"id": 1, "src": "<IR>", "tgt": "<IR>", "src-fn": "f", "tgt-fn": "g",
+ *    "passes": "instcombine"}
+ * Only "src" is required; the rest work as the corresponding command-line
+ * arguments, with "tgt" in place of the second file. The reply is a line
+ * with the id, the number of correct/unsound/failed/errors, and the report:
+ *   {"id": 1, "correct": 1, "unsound": 0, "failed": 0, "errors": 0,
+ *    "report": "..."}
+ * or {"id": 1, "error": "..."} if the request couldn't be processed.
+ * What is saved is the process startup and the TLI of each target, which
+ * are kept across requests. Each request gets a fresh LLVMContext, as types
+ * and constants would otherwise pile up in it forever, and Z3 is reset for
+ * each function, as in the other modes.
+ */
+class Server {
+  smt::smt_initializer &smt_init;
+  llvm::StringMap<unique_ptr<llvm::TargetLibraryInfoWrapperPass>> TLIs;
+  stringstream report;
+
+  llvm::json::Object process(const llvm::json::Object &req);
+
+public:
+  Server(smt::smt_initializer &smt_init) : smt_init(smt_init) {}
+
+  // serves requests until the end of the input
+  void serve(int in_fd, int out_fd);
+};
+
+llvm::json::Object Server::process(const llvm::json::Object &req) {
+  auto error = [](const string &msg) {
+    return llvm::json::Object{{"error", msg}};
+  };
+  auto str = [&](const char *key, const string &def) {
+    auto v = req.getString(key);
+    return v ? v->str() : def;
+  };
+
+  llvm::LLVMContext Context;
+  auto parse = [&](const char *key) -> unique_ptr<llvm::Module> {
+    auto ir = req.getString(key);
+    if (!ir)
+      return nullptr;
+    llvm::SMDiagnostic Diag;
+    return llvm::parseIR(llvm::MemoryBufferRef(*ir, key), Diag, Context);
+  };
+
+  if (!req.getString("src"))
+    return error("Missing src");
+
+  auto M1 = parse("src");
+  if (!M1)
+    return error("Could not parse src");
+  if (llvm::verifyModule(*M1))
+    return error("Source file is broken");
+
+  unique_ptr<llvm::Module> M2;
+  if (req.getString("tgt")) {
+    M2 = parse("tgt");
+    if (!M2)
+      return error("Could not parse tgt");
+    if (M1->getTargetTriple() != M2->getTargetTriple())
+      return error("Modules have different target triples");
+    if (llvm::verifyModule(*M2))
+      return error("Target file is broken");
+  }
+
+  llvm::Triple targetTriple(M1->getTargetTriple());
+  auto &TLI = TLIs[targetTriple.str()];
+  if (!TLI)
+    TLI = make_unique<llvm::TargetLibraryInfoWrapperPass>(targetTriple);
+
+  report.str({});
+  set_outs(report);
+  set_data_layout(M1->getDataLayout());
+
+  Verifier verifier(*TLI, smt_init, report);
+  verifier.always_verify = opt_always_verify;
+  verifier.print_dot = opt_print_dot;
+  verifier.bidirectional = opt_bidirectional;
+
+  auto compare = [&](llvm::Function &F1, llvm::Function &F2) {
+    return verifier.compareFunctions(F1, F2) || !opt_error_fatal;
+  };
+
+  if (!M2) {
+    bool stopped = false;
+    if (compareSrcTgtPairs(*M1, str("src-fn", opt_src_fn),
+                           str("tgt-fn", opt_tgt_fn), compare, stopped) == 0) {
+      M2 = CloneModule(*M1);
+      auto err = optimize_module(M2.get(), str("passes", optPass));
+      if (!err.empty())
+        return error("Error parsing list of LLVM passes: " + err);
+    }
+  }
+  if (M2)
+    compareModules(*M1, *M2, compare);
+
+  return llvm::json::Object{
+    {"correct", verifier.num_correct},
+    {"unsound", verifier.num_unsound},
+    {"failed", verifier.num_failed},
+    {"errors", verifier.num_errors},
+    {"report", report.str()},
+  };
+}
+
+void Server::serve(int in_fd, int out_fd) {
+  string buf;
+  char chunk[64 * 1024];
+  bool eof = false;
+
+  while (true) {
+    auto nl = buf.find('\n');
+    if (nl == string::npos && !eof) {
+      auto n = read(in_fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        eof = true;
+      else
+        buf.append(chunk, n);
+      continue;
+    }
+    if (nl == string::npos && buf.empty())
+      return;
+
+    string line = buf.substr(0, nl);
+    buf.erase(0, nl == string::npos ? nl : nl + 1);
+    if (line.find_first_not_of(" \t\r") == string::npos)
+      continue;
+
+    llvm::json::Object reply;
+    auto req = llvm::json::parse(line);
+    if (!req) {
+      reply["error"] = "Invalid JSON: " + llvm::toString(req.takeError());
+    } else if (auto *obj = req->getAsObject()) {
+      reply = process(*obj);
+      if (auto *id = obj->get("id"))
+        reply["id"] = *id;
+    } else {
+      reply["error"] = "Request is not a JSON object";
+    }
+
+    string out;
+    llvm::raw_string_ostream os(out);
+    os << llvm::json::Value(std::move(reply)) << '\n';
+    os.flush();
+
+    string_view data = out;
+    while (!data.empty()) {
+      auto n = write(out_fd, data.data(), data.size());
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return;
+      data.remove_prefix(n);
+    }
+  }
+}
+
+int serve(smt::smt_initializer &smt_init) {
+  Server server(smt_init);
+  if (opt_serve.empty()) {
+    server.serve(STDIN_FILENO, STDOUT_FILENO);
+    return 0;
+  }
+
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (opt_serve.size() >= sizeof(addr.sun_path)) {
+    cerr << "Socket path is too long: " << opt_serve << '\n';
+    return -1;
+  }
+  strcpy(addr.sun_path, opt_serve.c_str());
+
+  // replace a stale socket from a previous run, but nothing else
+  struct stat st;
+  if (lstat(addr.sun_path, &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      cerr << "Not a socket: " << opt_serve << '\n';
+      return -1;
+    }
+    unlink(addr.sun_path);
+  }
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+      listen(sock, 16) != 0) {
+    perror("Couldn't listen on the socket");
+    return -1;
+  }
+
+  // a client hanging up must not kill the server
+  signal(SIGPIPE, SIG_IGN);
+
+  // clients are served one at a time
+  while (true) {
+    int conn = accept(sock, nullptr, nullptr);
+    if (conn < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("accept() failed");
+      return -1;
+    }
+    server.serve(conn, conn);
+    close(conn);
+  }
+}
 
 }
 
@@ -78,7 +416,6 @@ int main(int argc, char **argv) {
   llvm::InitLLVM X(argc, argv);
   llvm::EnableDebugBuffering = true;
   llvm::LLVMContext Context;
-  unsigned M1_anon_count = 0;
 
   std::string Usage =
       R"EOF(Alive2 stand-alone translation validator:
@@ -117,10 +454,19 @@ and "tgt5" will unused.
   llvm::cl::HideUnrelatedOptions(alive_cmdargs);
   llvm::cl::ParseCommandLineOptions(argc, argv, Usage);
 
-  auto M1 = openInputFile(Context, opt_file1);
-  if (!M1.get()) {
-    cerr << "Could not read bitcode from '" << opt_file1 << "'\n";
+  unique_ptr<llvm::Module> M1;
+  if (opt_serve.getNumOccurrences()) {
+    // requests bring their own modules
+    M1 = make_unique<llvm::Module>("serve", Context);
+  } else if (opt_file1.empty()) {
+    cerr << "No input file given\n";
     return -1;
+  } else {
+    M1 = openInputFile(Context, opt_file1);
+    if (!M1.get()) {
+      cerr << "Could not read bitcode from '" << opt_file1 << "'\n";
+      return -1;
+    }
   }
 
 #define ARGS_MODULE_VAR M1
@@ -142,44 +488,99 @@ and "tgt5" will unused.
   verifier.print_dot = opt_print_dot;
   verifier.bidirectional = opt_bidirectional;
 
-  unique_ptr<llvm::Module> M2;
-  if (opt_file2.empty()) {
-    unsigned Cnt = 0;
-    for (auto &F1 : *M1.get()) {
-      if (F1.isDeclaration())
-        continue;
-      auto SrcFName = F1.getName();
-      if (!SrcFName.starts_with(opt_src_fn))
-        continue;
-
-      // Check src{+d}/tgt{+d} variant
-      if (std::find_if(SrcFName.begin() + opt_src_fn.length(), SrcFName.end(),
-                       [](unsigned char c) { return !std::isdigit(c); }) ==
-          SrcFName.end()) {
-        // Pass, we found a valid postfix
+  if (opt_serve.getNumOccurrences())
+    return serve(smt_init);
+
+  /*
+   * with -j, each function pair is verified in a forked child process.
+   * the parent leaves placeholders in parent_ss that the parallel
+   * manager replaces with the children's output, so the report comes
+   * out in module order. verdicts are sent back through exit codes.
+   */
+  ostream *out_orig = out;
+  stringstream parent_ss;
+  unique_ptr<parallel> parallelMgr;
+  vector<int> pending_jobs;
+  bool found_unsound = false;
+
+  // counts the jobs that have been reaped; the others stay pending
+  auto tallyJobs = [&]() {
+    erase_if(pending_jobs, [&](int index) {
+      auto status = parallelMgr->getExitStatus(index);
+      if (!status)
+        return false;
+      if (!WIFEXITED(*status)) {
+        ++verifier.num_errors;
+        return true;
       }
-      // Check src_*/tgt_* variant
-      else if (SrcFName.str().length() > opt_src_fn.length() &&
-               SrcFName[opt_src_fn.length()] == '_') {
-        // Pass, we found a valid postfix
-      }
-      // No valid postfix.
-      else {
-        continue;
+      switch (WEXITSTATUS(*status)) {
+      case CHILD_CORRECT: ++verifier.num_correct; break;
+      case CHILD_UNSOUND: ++verifier.num_unsound; found_unsound = true; break;
+      case CHILD_FAILED:  ++verifier.num_failed; break;
+      default:            ++verifier.num_errors; break;
       }
+      return true;
+    });
+  };
+
+  auto finishJobs = [&]() {
+    if (!parallelMgr)
+      return;
+    parallelMgr->finishParent();
+    out = out_orig;
+    set_outs(*out);
+    tallyJobs();
+    parallelMgr.reset();
+  };
+
+  // returns false if verification should stop
+  auto compare = [&](llvm::Function &F1, llvm::Function &F2) {
+    if (opt_jobs <= 1)
+      return verifier.compareFunctions(F1, F2) || !opt_error_fatal;
+
+    if (!parallelMgr) {
+      parallelMgr = make_unique<unrestricted>(opt_jobs, parent_ss, *out);
+      ENSURE(parallelMgr->init());
+      out = &parent_ss;
+      set_outs(*out);
+    }
 
-      // Check if we have tgt + same postfix
-      auto DstFName =
-          SrcFName.str().replace(0, opt_src_fn.length(), opt_tgt_fn);
-      auto SRC = findFunction(*M1, SrcFName.str());
-      auto TGT = findFunction(*M1, DstFName);
-      if (SRC && TGT) {
-        ++Cnt;
-        if (!verifier.compareFunctions(*SRC, *TGT))
-          if (opt_error_fatal)
-            goto end;
-      }
+    tallyJobs();
+    if (found_unsound && opt_error_fatal)
+      return false;
+
+    auto [pid, osp, index] = parallelMgr->limitedFork();
+    if (pid == -1) {
+      perror("fork() failed");
+      exit(-1);
     }
+
+    if (pid != 0) {
+      *out << "include(" << index << ")\n";
+      pending_jobs.emplace_back(index);
+      return true;
+    }
+
+    out = osp;
+    set_outs(*out);
+    Verifier child_verifier(TLI, smt_init, *out);
+    child_verifier.always_verify = verifier.always_verify;
+    child_verifier.print_dot = verifier.print_dot;
+    child_verifier.bidirectional = verifier.bidirectional;
+    bool ok = child_verifier.compareFunctions(F1, F2);
+    if (opt_smt_stats)
+      smt::solver_print_stats(*out);
+    parallelMgr->finishChild(/*is_timeout=*/false);
+    exit(childResult(child_verifier, ok));
+  };
+
+  unique_ptr<llvm::Module> M2;
+  if (opt_file2.empty()) {
+    bool stopped = false;
+    unsigned Cnt = compareSrcTgtPairs(*M1, opt_src_fn, opt_tgt_fn, compare,
+                                      stopped);
+    if (stopped)
+      goto end;
     if (Cnt == 0) {
       M2 = CloneModule(*M1);
       auto err = optimize_module(M2.get(), optPass);
@@ -210,31 +611,11 @@ and "tgt5" will unused.
     return -1;
   }
 
-  // FIXME: quadratic, may not be suitable for very large modules
-  // emitted by opt-fuzz
-  for (auto &F1 : *M1.get()) {
-    if (F1.isDeclaration())
-      continue;
-    if (F1.getName().empty())
-      M1_anon_count++;
-    if (!func_names.empty() && !func_names.count(F1.getName().str()))
-      continue;
-    unsigned M2_anon_count = 0;
-    for (auto &F2 : *M2.get()) {
-      if (F2.isDeclaration())
-        continue;
-      if (F2.getName().empty())
-        M2_anon_count++;
-      if ((F1.getName().empty() && (M1_anon_count == M2_anon_count)) ||
-          (F1.getName() == F2.getName())) {
-        if (!verifier.compareFunctions(F1, F2))
-          if (opt_error_fatal)
-            goto end;
-        break;
-      }
-    }
-  }
+  if (!compareModules(*M1, *M2, compare))
+    goto end;
+
 summary:
+  finishJobs();
   *out << "Summary:\n"
           "  " << verifier.num_correct << " correct transformations\n"
           "  " << verifier.num_unsound << " incorrect transformations\n"
@@ -242,6 +623,7 @@ summary:
           "  " << verifier.num_errors << " Alive2 errors\n";
 
 end:
+  finishJobs();
   if (opt_smt_stats)
     smt::solver_print_stats(*out);
 
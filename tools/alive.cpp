@@ -5,11 +5,22 @@
 #include "smt/solver.h"
 #include "tools/alive_parser.h"
 #include "util/config.h"
+#include "util/compiler.h"
 #include "util/file.h"
+#include "util/parallel.h"
 #include "util/version.h"
+#include <atomic>
+#include <climits>
+#include <csignal>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string_view>
+#include <sys/mman.h>
+#include <sys/time.h>
 #include <vector>
 
 using namespace IR;
@@ -34,16 +45,115 @@ static void show_help() {
           " -tactic-verbose\tDebug SMT tactics\n"
           " -smt-log\t\tLog interactions with the SMT solver\n"
           " -skip-smt\t\tSkip all SMT queries\n"
+          " -check-typings\tCheck the typings enumerated natively against"
+          " the SMT solver's\n\t\t\tinstead of verifying the transforms\n"
           " -disable-poison-input\tAssume input variables can never be poison\n"
           " -disable-undef-input\tAssume input variables can never be undef\n"
+          " -j N\t\t\tVerify transforms and typings in N processes\n"
+          " -mmap\t\t\tMap the input files into memory instead of reading"
+          " them\n"
           " -h / --help / -v / --version\tShow this help\n";
 }
 
+// State shared by the processes verifying the typings of a transform
+struct SharedTypings {
+  // index of the first typing found not to verify
+  std::atomic<unsigned> failed_at = UINT_MAX;
+  // the parent, while it forks children, plus the children still running
+  std::atomic<unsigned> remaining = 1;
+  std::atomic<unsigned> verified = 0;
+};
+
+// Reports the result once all typings are done: success, or the errors of
+// the first typing that doesn't verify, like a sequential run would.
+// mine are the errors of the typing the caller verified, if any.
+static void report_typings(TransformVerify &tv, SharedTypings &sh,
+                           ostream &os, const Errors *mine, unsigned idx) {
+  unsigned failed_at = sh.failed_at;
+  if (failed_at == UINT_MAX) {
+    os << "Done: " << sh.verified
+       << "\nTransformation seems to be correct!\n";
+    return;
+  }
+
+  os << "Done: " << failed_at << '\n';
+  if (mine && idx == failed_at) {
+    os << *mine;
+    return;
+  }
+
+  // the errors are in another process; verify that typing again
+  auto types = tv.getTypings();
+  for (unsigned i = 0; i < failed_at; ++i) {
+    ++types;
+  }
+  tv.fixupTypes(types);
+  os << tv.verify();
+}
+
+// The typing verified by this child process, for cancel_typing()
+static SharedTypings *child_sh;
+static unsigned child_idx;
+static parallel *child_mgr;
+
+// Called periodically in the children: stops verifying a typing once an
+// earlier one is known to fail. The last process of the transform keeps
+// going, as it has to report the result.
+static void cancel_typing(int) {
+  if (child_idx < child_sh->failed_at)
+    return;
+
+  unsigned remaining = child_sh->remaining;
+  while (remaining > 1) {
+    if (child_sh->remaining.compare_exchange_weak(remaining, remaining - 1)) {
+      child_mgr->finishChild(/*is_timeout=*/false);
+      // this is a fully asynchronous exit, skip destructors and such
+      _Exit(0);
+    }
+  }
+}
+
+static void set_cancel_timer(bool enable) {
+  itimerval timer = {};
+  if (enable) {
+    timer.it_interval.tv_usec = 100 * 1000;
+    timer.it_value = timer.it_interval;
+  }
+  ENSURE(setitimer(ITIMER_REAL, &timer, nullptr) == 0);
+}
+
+// Verifies typing idx, unless an earlier one already failed. The last
+// process of the transform to finish reports the result.
+static void verify_typing(TransformVerify &tv, TypingAssignments &types,
+                          unsigned idx, SharedTypings &sh, ostream &os) {
+  optional<Errors> errs;
+  if (idx < sh.failed_at) {
+    tv.fixupTypes(types);
+    set_cancel_timer(true);
+    errs = tv.verify();
+    set_cancel_timer(false);
+    errs->printWarnings(os);
+    if (*errs) {
+      unsigned failed_at = sh.failed_at;
+      while (idx < failed_at &&
+             !sh.failed_at.compare_exchange_weak(failed_at, idx));
+    } else {
+      ++sh.verified;
+    }
+  }
+
+  if (--sh.remaining == 0)
+    report_typings(tv, sh, os, errs ? &*errs : nullptr, idx);
+}
+
 
 int main(int argc, char **argv) {
   bool verbose = false;
   bool show_smt_stats = false;
   bool root_only = false;
+  bool check_typings = false;
+  unsigned num_jobs = 1;
+  bool use_mmap = false;
 
   int argc_i = 1;
   for (; argc_i < argc; ++argc_i) {
@@ -72,10 +182,18 @@ int main(int argc, char **argv) {
       smt::start_logging();
     else if (arg == "-skip-smt")
       config::skip_smt = true;
+    else if (arg == "-check-typings")
+      check_typings = true;
     else if (arg == "-disable-undef-input")
       config::disable_undef_input = true;
     else if (arg == "-disable-poison-input")
       config::disable_poison_input = true;
+    else if (arg == "-j" && argc_i + 1 < argc)
+      num_jobs = strtoul(argv[++argc_i], nullptr, 10);
+    else if (arg.compare(0, 2, "-j") == 0 && arg.size() > 2)
+      num_jobs = strtoul(arg.substr(2).data(), nullptr, 10);
+    else if (arg == "-mmap")
+      use_mmap = true;
     else if (arg == "-h" || arg == "--help" || arg == "-v" ||
              arg == "--version") {
       show_help();
@@ -102,24 +220,127 @@ int main(int argc, char **argv) {
   TransformPrintOpts print_opts;
   print_opts.print_fn_header = false;
 
+  /*
+   * with -j, each typing of a transform is verified in a child process
+   * forked when the parent enumerates it, and up to N are verified at a
+   * time, across transforms. The output of the children is stitched in
+   * order in place of the include(N) placeholders left in parent_ss.
+   * Errors are stitched into the same stream so they stay next to the
+   * transform they belong to; children past the first failing typing of a
+   * transform are cancelled.
+   */
+  ostream *out = &cout, *err = &cerr;
+  stringstream parent_ss;
+  unique_ptr<parallel> parallelMgr;
+  vector<SharedTypings*> shared_mem;
+  constexpr unsigned shared_chunk = 1024;
+  unsigned shared_used = shared_chunk;
+  if (num_jobs > 1) {
+    parallelMgr = make_unique<unrestricted>(num_jobs, parent_ss, cout);
+    ENSURE(parallelMgr->init());
+    out = err = &parent_ss;
+  }
+
+  auto finish = [&]() {
+    if (!parallelMgr)
+      return;
+    parallelMgr->finishParent();
+    parallelMgr.reset();
+    for (auto *ptr : shared_mem) {
+      munmap(ptr, sizeof(SharedTypings) * shared_chunk);
+    }
+  };
+
   for (; argc_i < argc; ++argc_i) {
-    cout << "Processing " << argv[argc_i] << "..\n";
+    *out << "Processing " << argv[argc_i] << "..\n";
     try {
-      for (auto &t : parse(*file_reader(argv[argc_i], PARSER_READ_AHEAD))) {
+      file_reader input(argv[argc_i], PARSER_READ_AHEAD, use_mmap);
+      transform_parser parser(*input);
+
+      // transforms are verified as they are parsed, so the whole file is
+      // never in memory at once
+      while (auto tp = parser.next()) {
+        auto &t = *tp;
         smt_init.reset();
 
         if (root_only && (!t.src.hasReturn() || !t.tgt.hasReturn())) {
-          cerr << "Return instruction required with -root-only.\n";
+          *err << "Return instruction required with -root-only.\n";
           continue;
         }
 
-        t.print(cout, print_opts);
-        cout << '\n';
+        t.print(*out, print_opts);
+        *out << '\n';
 
         TransformVerify tv(t, !root_only);
         auto types = tv.getTypings();
         if (!types) {
-          cerr << "Doesn't type check!\n";
+          *err << "Doesn't type check!\n";
+          continue;
+        }
+
+        if (check_typings) {
+          unsigned num;
+          auto errs = tv.checkTypings(num);
+          errs.printWarnings(*err);
+          *out << "Typings: " << num << '\n';
+          if (errs)
+            *err << errs;
+          continue;
+        }
+
+        if (parallelMgr) {
+          if (shared_used == shared_chunk) {
+            void *p = mmap(nullptr, sizeof(SharedTypings) * shared_chunk,
+                           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                           -1, 0);
+            if (p == MAP_FAILED) {
+              perror("mmap() failed");
+              return -1;
+            }
+            shared_mem.emplace_back(static_cast<SharedTypings*>(p));
+            shared_used = 0;
+          }
+          auto &sh = *new (&shared_mem.back()[shared_used++]) SharedTypings();
+
+          // stop at the first typing known to fail
+          for (unsigned i = 0; types && i < sh.failed_at; ++types, ++i) {
+            ++sh.remaining;
+            auto [pid, osp, index] = parallelMgr->limitedFork();
+            if (pid == -1) {
+              perror("fork() failed");
+              exit(-1);
+            }
+
+            if (pid != 0) {
+              parent_ss << "include(" << index << ")\n";
+              continue;
+            }
+
+            child_sh = &sh;
+            child_idx = i;
+            child_mgr = parallelMgr.get();
+            signal(SIGALRM, cancel_typing);
+            verify_typing(tv, types, i, sh, *osp);
+            parallelMgr->finishChild(/*is_timeout=*/false);
+            exit(0);
+          }
+
+          // the children finished first; one more reports the result
+          if (--sh.remaining == 0) {
+            auto [pid, osp, index] = parallelMgr->limitedFork();
+            if (pid == -1) {
+              perror("fork() failed");
+              exit(-1);
+            }
+
+            if (pid != 0) {
+              parent_ss << "include(" << index << ")\n";
+            } else {
+              report_typings(tv, sh, *osp, nullptr, 0);
+              parallelMgr->finishChild(/*is_timeout=*/false);
+              exit(0);
+            }
+          }
           continue;
         }
 
@@ -141,13 +362,16 @@ int main(int argc, char **argv) {
           cout << "Transformation seems to be correct!\n";
       }
     } catch (const FileIOException &e) {
+      finish();
       cerr << "Couldn't read the file" << endl;
       return -2;
     } catch (const ParseException &e) {
+      finish();
       cerr << "Parse error in line: " << e.lineno << ": " << e.str << endl;
       return -3;
     }
   }
+  finish();
 
   if (show_smt_stats)
     smt::solver_print_stats(cout);
@@ -1424,52 +1424,80 @@ static void parse_arrow() {
   tokenizer.ensure(ARROW);
 }
 
+static void parse_transform(Transform &t) {
+  sym_num = struct_num = 0;
+  parse_src = true;
+
+  parse_name(t);
+  parse_pre(t);
+  parse_fn(t.src);
+  parse_arrow();
+
+  // copy inputs from src to target
+  decltype(identifiers) identifiers_tgt;
+  for (auto &val : t.src.getInputs()) {
+    auto &name = val.getName();
+    if (dynamic_cast<const Input*>(&val)) {
+      auto input = make_unique<Input>(val.getType(), string(name));
+      identifiers_tgt.emplace(name, input.get());
+      t.tgt.addInput(std::move(input));
+    } else {
+      assert(dynamic_cast<const ConstantInput*>(&val));
+      auto input = make_unique<ConstantInput>(val.getType(), string(name));
+      identifiers_tgt.emplace(name, input.get());
+      t.tgt.addInput(std::move(input));
+    }
+  }
+  identifiers_src = std::move(identifiers);
+  identifiers = std::move(identifiers_tgt);
+
+  parse_src = false;
+  parse_fn(t.tgt);
+
+  // copy any missing instruction in tgt from src
+  for (auto &[name, val] : identifiers_src) {
+    get_or_copy_instr(name);
+  }
+
+  t.src.number();
+  t.tgt.number();
+
+  identifiers.clear();
+  identifiers_src.clear();
+}
+
 vector<Transform> parse(string_view buf) {
   vector<Transform> ret;
 
   yylex_init(buf);
 
   while (!tokenizer.empty()) {
-    auto &t = ret.emplace_back();
-    sym_num = struct_num = 0;
-    parse_src = true;
-
-    parse_name(t);
-    parse_pre(t);
-    parse_fn(t.src);
-    parse_arrow();
-
-    // copy inputs from src to target
-    decltype(identifiers) identifiers_tgt;
-    for (auto &val : t.src.getInputs()) {
-      auto &name = val.getName();
-      if (dynamic_cast<const Input*>(&val)) {
-        auto input = make_unique<Input>(val.getType(), string(name));
-        identifiers_tgt.emplace(name, input.get());
-        t.tgt.addInput(std::move(input));
-      } else {
-        assert(dynamic_cast<const ConstantInput*>(&val));
-        auto input = make_unique<ConstantInput>(val.getType(), string(name));
-        identifiers_tgt.emplace(name, input.get());
-        t.tgt.addInput(std::move(input));
-      }
-    }
-    identifiers_src = std::move(identifiers);
-    identifiers = std::move(identifiers_tgt);
+    parse_transform(ret.emplace_back());
+  }
 
-    parse_src = false;
-    parse_fn(t.tgt);
+  return ret;
+}
 
-    // copy any missing instruction in tgt from src
-    for (auto &[name, val] : identifiers_src) {
-      get_or_copy_instr(name);
-    }
 
-    identifiers.clear();
-    identifiers_src.clear();
-  }
+transform_parser::transform_parser(string_view buf) {
+  yylex_init(buf);
+}
 
-  return ret;
+unique_ptr<Transform> transform_parser::next() {
+  // the previous transform is gone, and so can be the types created for it
+  sym_types.clear();
+  vector_types.clear();
+  array_types.clear();
+  struct_types.clear();
+  overflow_aggregate_types.clear();
+  float_i32_types.clear();
+
+  if (tokenizer.empty())
+    return nullptr;
+
+  auto t = make_unique<Transform>();
+  parse_transform(*t);
+  return t;
 }
 
 
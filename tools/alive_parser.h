@@ -4,6 +4,7 @@
 // Distributed under the MIT license that can be found in the LICENSE file.
 
 #include "tools/transform.h"
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -14,6 +15,18 @@ namespace tools {
 
 std::vector<Transform> parse(std::string_view buf);
 
+// Parses the transforms in buf one at a time, so each one can be verified
+// before the rest of the input is parsed, and only one is kept in memory.
+// A transform must be destroyed before calling next() again, as that frees
+// its types. Only one parser can be active at a time.
+class transform_parser {
+public:
+  transform_parser(std::string_view buf);
+
+  // returns null at the end of the input
+  std::unique_ptr<Transform> next();
+};
+
 struct parser_initializer {
   parser_initializer();
   ~parser_initializer();
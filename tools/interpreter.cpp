@@ -0,0 +1,926 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "tools/interpreter.h"
+#include "ir/constant.h"
+#include "ir/function.h"
+#include "ir/instr.h"
+#include "ir/type.h"
+#include "util/compiler.h"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <sstream>
+
+using namespace IR;
+using namespace tools;
+using namespace std;
+
+namespace {
+
+struct Stop {
+  Interpreter::Status status;
+  string msg;
+};
+
+[[noreturn]] void ub() {
+  throw Stop{Interpreter::UB, {}};
+}
+
+[[noreturn]] void not_supported(string &&msg) {
+  throw Stop{Interpreter::Unsupported, std::move(msg)};
+}
+
+bool supported_type(const Type &ty) {
+  return ty.isVoid() || ty.isPtrType() || (ty.isIntType() && ty.bits() <= 64);
+}
+
+unsigned width(const Type &ty) {
+  return ty.isIntType() ? ty.bits() : 0;
+}
+
+uint64_t mask(unsigned bits) {
+  return bits >= 64 ? ~0ull : (1ull << bits) - 1;
+}
+
+int64_t sext(uint64_t n, unsigned bits) {
+  return bits >= 64 ? (int64_t)n
+                    : (int64_t)(n << (64 - bits)) >> (64 - bits);
+}
+
+int64_t smin(unsigned bits) {
+  return bits >= 64 ? INT64_MIN : -(int64_t(1) << (bits - 1));
+}
+
+int64_t smax(unsigned bits) {
+  return bits >= 64 ? INT64_MAX : (int64_t(1) << (bits - 1)) - 1;
+}
+
+bool fits_signed(int64_t n, unsigned bits) {
+  return n >= smin(bits) && n <= smax(bits);
+}
+
+// Each use of undef may observe a different value; we always pick zero.
+ConcreteVal resolve(ConcreteVal v) {
+  if (v.undef) {
+    v.undef = false;
+    v.bits  = 0;
+    v.bid   = 0;
+  }
+  return v;
+}
+
+ConcreteVal binop(const BinOp &i, ConcreteVal a, ConcreteVal b, unsigned bits) {
+  auto op = i.getOp();
+  auto flags = i.getFlags();
+  bool is_div = op == BinOp::SDiv || op == BinOp::UDiv ||
+                op == BinOp::SRem || op == BinOp::URem;
+
+  if (is_div && (b.poison || b.undef))
+    ub();
+
+  if (op == BinOp::UCmp || op == BinOp::SCmp) {
+    if (a.poison || b.poison)
+      return ConcreteVal::mkPoison(false);
+    a = resolve(a);
+    b = resolve(b);
+    int cmp = op == BinOp::UCmp
+                ? (a.bits < b.bits ? -1 : a.bits != b.bits)
+                : (sext(a.bits, bits) < sext(b.bits, bits) ? -1
+                                                           : a.bits != b.bits);
+    return ConcreteVal::mkInt((uint64_t)(int64_t)cmp & mask(width(i.getType())));
+  }
+
+  a = resolve(a);
+  b = resolve(b);
+  uint64_t x = a.bits, y = b.bits, m = mask(bits), r = 0;
+  int64_t sx = sext(x, bits), sy = sext(y, bits), sr;
+  bool np = true;
+
+  switch (op) {
+  case BinOp::Add:
+    r = (x + y) & m;
+    if (flags & BinOp::NSW)
+      np &= !__builtin_add_overflow(sx, sy, &sr) && fits_signed(sr, bits);
+    if (flags & BinOp::NUW)
+      np &= !__builtin_add_overflow(x, y, &r) && r <= m;
+    r &= m;
+    break;
+
+  case BinOp::Sub:
+    r = (x - y) & m;
+    if (flags & BinOp::NSW)
+      np &= !__builtin_sub_overflow(sx, sy, &sr) && fits_signed(sr, bits);
+    if (flags & BinOp::NUW)
+      np &= x >= y;
+    break;
+
+  case BinOp::Mul:
+    r = (x * y) & m;
+    if (flags & BinOp::NSW)
+      np &= !__builtin_mul_overflow(sx, sy, &sr) && fits_signed(sr, bits);
+    if (flags & BinOp::NUW)
+      np &= !__builtin_mul_overflow(x, y, &r) && r <= m;
+    r = (x * y) & m;
+    break;
+
+  case BinOp::SDiv:
+  case BinOp::SRem:
+    if (y == 0 || (sy == -1 && (a.poison || sx == smin(bits))))
+      ub();
+    r = (op == BinOp::SDiv ? sx / sy : sx % sy) & m;
+    if (op == BinOp::SDiv && (flags & BinOp::Exact))
+      np &= sx % sy == 0;
+    break;
+
+  case BinOp::UDiv:
+  case BinOp::URem:
+    if (y == 0)
+      ub();
+    r = op == BinOp::UDiv ? x / y : x % y;
+    if (op == BinOp::UDiv && (flags & BinOp::Exact))
+      np &= x % y == 0;
+    break;
+
+  case BinOp::Shl:
+    if (y >= bits)
+      return ConcreteVal::mkPoison(false);
+    r = (x << y) & m;
+    if (flags & BinOp::NSW)
+      np &= (sext(r, bits) >> y) == sx;
+    if (flags & BinOp::NUW)
+      np &= (r >> y) == x;
+    break;
+
+  case BinOp::AShr:
+  case BinOp::LShr:
+    if (y >= bits)
+      return ConcreteVal::mkPoison(false);
+    r = (op == BinOp::AShr ? (uint64_t)(sx >> y) : x >> y) & m;
+    if (flags & BinOp::Exact)
+      np &= ((r << y) & m) == x;
+    break;
+
+  case BinOp::SAdd_Sat:
+  case BinOp::SSub_Sat: {
+    bool ovf = op == BinOp::SAdd_Sat ? __builtin_add_overflow(sx, sy, &sr)
+                                     : __builtin_sub_overflow(sx, sy, &sr);
+    if (ovf || !fits_signed(sr, bits))
+      sr = (op == BinOp::SAdd_Sat ? sy >= 0 : sy < 0) ? smax(bits)
+                                                       : smin(bits);
+    r = (uint64_t)sr & m;
+    break;
+  }
+
+  case BinOp::UAdd_Sat:
+    if (__builtin_add_overflow(x, y, &r) || r > m)
+      r = m;
+    break;
+
+  case BinOp::USub_Sat:
+    r = x >= y ? x - y : 0;
+    break;
+
+  case BinOp::SShl_Sat:
+    if (y >= bits)
+      return ConcreteVal::mkPoison(false);
+    r = (x << y) & m;
+    if ((sext(r, bits) >> y) != sx)
+      r = (uint64_t)(sx < 0 ? smin(bits) : smax(bits)) & m;
+    break;
+
+  case BinOp::UShl_Sat:
+    if (y >= bits)
+      return ConcreteVal::mkPoison(false);
+    r = (x << y) & m;
+    if ((r >> y) != x)
+      r = m;
+    break;
+
+  case BinOp::And:
+    r = x & y;
+    break;
+
+  case BinOp::Or:
+    r = x | y;
+    if (flags & BinOp::Disjoint)
+      np &= (x & y) == 0;
+    break;
+
+  case BinOp::Xor:
+    r = x ^ y;
+    break;
+
+  case BinOp::Cttz:
+    r = x == 0 ? bits : countr_zero(x);
+    np &= y == 0 || x != 0;
+    break;
+
+  case BinOp::Ctlz:
+    r = x == 0 ? bits : countl_zero(x) - (64 - bits);
+    np &= y == 0 || x != 0;
+    break;
+
+  case BinOp::UMin:
+    r = min(x, y);
+    break;
+
+  case BinOp::UMax:
+    r = max(x, y);
+    break;
+
+  case BinOp::SMin:
+    r = (uint64_t)min(sx, sy) & m;
+    break;
+
+  case BinOp::SMax:
+    r = (uint64_t)max(sx, sy) & m;
+    break;
+
+  case BinOp::Abs:
+    r = (sx < 0 ? -x : x) & m;
+    np &= y == 0 || sx != smin(bits);
+    break;
+
+  default:
+    not_supported("binary operation");
+  }
+
+  if (a.poison || b.poison || !np)
+    return ConcreteVal::mkPoison(false);
+  return ConcreteVal::mkInt(r);
+}
+
+ConcreteVal unop(const UnaryOp &i, ConcreteVal a, unsigned bits) {
+  if (i.getOp() == UnaryOp::Copy || a.poison)
+    return a;
+
+  a = resolve(a);
+  uint64_t x = a.bits, r = 0;
+  switch (i.getOp()) {
+  case UnaryOp::BitReverse:
+    for (unsigned idx = 0; idx < bits; ++idx) {
+      r |= ((x >> idx) & 1) << (bits - idx - 1);
+    }
+    break;
+
+  case UnaryOp::BSwap:
+    for (unsigned idx = 0; idx < bits / 8; ++idx) {
+      r |= ((x >> (idx * 8)) & 0xff) << (bits - (idx + 1) * 8);
+    }
+    break;
+
+  case UnaryOp::Ctpop:
+    r = popcount(x);
+    break;
+
+  default:
+    not_supported("unary operation");
+  }
+  return ConcreteVal::mkInt(r);
+}
+
+ConcreteVal conversion(const ConversionOp &i, ConcreteVal a, unsigned from,
+                       unsigned to) {
+  if (a.poison)
+    return a;
+
+  a = resolve(a);
+  uint64_t x = a.bits, r = 0;
+  auto flags = i.getFlags();
+  bool np = true;
+
+  switch (i.getOp()) {
+  case ConversionOp::SExt:
+    r = (uint64_t)sext(x, from) & mask(to);
+    break;
+
+  case ConversionOp::ZExt:
+    r = x;
+    if (flags & ConversionOp::NNEG)
+      np &= sext(x, from) >= 0;
+    break;
+
+  case ConversionOp::Trunc:
+    r = x & mask(to);
+    if (flags & ConversionOp::NSW)
+      np &= sext(r, to) == sext(x, from);
+    if (flags & ConversionOp::NUW)
+      np &= r == x;
+    break;
+
+  default:
+    not_supported("conversion");
+  }
+  return np ? ConcreteVal::mkInt(r) : ConcreteVal::mkPoison(false);
+}
+
+bool icmp(ICmp::Cond cond, uint64_t a, uint64_t b, unsigned bits) {
+  int64_t sa = sext(a, bits), sb = sext(b, bits);
+  switch (cond) {
+  case ICmp::EQ:  return a == b;
+  case ICmp::NE:  return a != b;
+  case ICmp::SLE: return sa <= sb;
+  case ICmp::SLT: return sa < sb;
+  case ICmp::SGE: return sa >= sb;
+  case ICmp::SGT: return sa > sb;
+  case ICmp::ULE: return a <= b;
+  case ICmp::ULT: return a < b;
+  case ICmp::UGE: return a >= b;
+  case ICmp::UGT: return a > b;
+  case ICmp::Any: break;
+  }
+  not_supported("icmp predicate");
+}
+
+bool supported_instr(const Instr &i) {
+  if (auto *op = dynamic_cast<const BinOp*>(&i)) {
+    switch (op->getOp()) {
+    case BinOp::SAdd_Overflow:
+    case BinOp::UAdd_Overflow:
+    case BinOp::SSub_Overflow:
+    case BinOp::USub_Overflow:
+    case BinOp::SMul_Overflow:
+    case BinOp::UMul_Overflow:
+      return false;
+    default:
+      return true;
+    }
+  }
+  if (auto *op = dynamic_cast<const UnaryOp*>(&i))
+    return op->getOp() != UnaryOp::IsConstant && op->getOp() != UnaryOp::FFS;
+  if (auto *op = dynamic_cast<const ConversionOp*>(&i))
+    return op->getOp() == ConversionOp::SExt ||
+           op->getOp() == ConversionOp::ZExt ||
+           op->getOp() == ConversionOp::Trunc;
+  if (auto *op = dynamic_cast<const ICmp*>(&i))
+    return op->getCond() != ICmp::Any;
+  if (auto *op = dynamic_cast<const Assume*>(&i))
+    return op->getKind() == Assume::AndNonPoison ||
+           op->getKind() == Assume::WellDefined;
+
+  return dynamic_cast<const Select*>(&i) ||
+         dynamic_cast<const Freeze*>(&i) ||
+         dynamic_cast<const Phi*>(&i) ||
+         dynamic_cast<const Branch*>(&i) ||
+         dynamic_cast<const Switch*>(&i) ||
+         dynamic_cast<const Return*>(&i) ||
+         dynamic_cast<const Alloc*>(&i) ||
+         dynamic_cast<const StartLifetime*>(&i) ||
+         dynamic_cast<const EndLifetime*>(&i) ||
+         dynamic_cast<const GEP*>(&i) ||
+         dynamic_cast<const Load*>(&i) ||
+         dynamic_cast<const Store*>(&i);
+}
+
+}
+
+ConcreteVal ConcreteVal::mkInt(uint64_t n) {
+  ConcreteVal v;
+  v.bits = n;
+  return v;
+}
+
+ConcreteVal ConcreteVal::mkPtr(unsigned bid, int64_t offset) {
+  ConcreteVal v;
+  v.bits   = offset;
+  v.bid    = bid;
+  v.is_ptr = true;
+  return v;
+}
+
+ConcreteVal ConcreteVal::mkPoison(bool is_ptr) {
+  ConcreteVal v;
+  v.is_ptr = is_ptr;
+  v.poison = true;
+  return v;
+}
+
+ConcreteVal ConcreteVal::mkUndef(bool is_ptr) {
+  ConcreteVal v;
+  v.is_ptr = is_ptr;
+  v.undef  = true;
+  return v;
+}
+
+
+Interpreter::Interpreter(const Function &f)
+  : f(f), ptr_bytes(f.bitsPointers() / 8) {
+  // block 0 is the null block
+  init_mem.emplace_back(Block{{}, 0, false, false, true});
+  num_nonlocals = 1;
+
+  if (!checkSupport())
+    return;
+
+  regs = init_regs;
+  mem  = init_mem;
+  entry = &f.getFirstBB();
+
+  // Constant globals are initialized by the #init block. It only needs to
+  // run once, as every run starts from the resulting memory.
+  if (entry->getName() == "#init") {
+    initializing = true;
+    try {
+      for (auto &i : entry->instrs()) {
+        if (!dynamic_cast<const JumpInstr*>(&i))
+          regs[slots.at(&i)] = exec(i);
+      }
+    } catch (const Stop &s) {
+      unsupported_reason = s.status == UB ? "UB in global initializers"
+                                          : s.msg;
+      return;
+    }
+    initializing = false;
+    entry = f.getBBs()[1];
+    init_regs = regs;
+    init_mem  = mem;
+  }
+}
+
+bool Interpreter::addConstant(const Value &v) {
+  ConcreteVal c;
+  bool is_ptr = v.getType().isPtrType();
+
+  if (auto *n = dynamic_cast<const IntConst*>(&v)) {
+    auto *i = n->getInt();
+    if (!i)
+      return false;
+    c = ConcreteVal::mkInt((uint64_t)*i & mask(width(v.getType())));
+  } else if (dynamic_cast<const UndefValue*>(&v)) {
+    c = ConcreteVal::mkUndef(is_ptr);
+  } else if (dynamic_cast<const PoisonValue*>(&v)) {
+    c = ConcreteVal::mkPoison(is_ptr);
+  } else if (dynamic_cast<const NullPointerValue*>(&v)) {
+    c = ConcreteVal::mkPtr(0, 0);
+  } else if (dynamic_cast<const VoidValue*>(&v)) {
+    // nothing to do
+  } else if (auto *gv = dynamic_cast<const GlobalVariable*>(&v)) {
+    if (gv->isArbitrarySize())
+      return false;
+    // The initial contents of non-constant globals are unknown; zero is as
+    // good a choice as any.
+    Byte zero;
+    zero.kind = Byte::Int;
+    init_mem.emplace_back(Block{vector<Byte>(gv->size(), zero),
+                                num_nonlocals++, false, true, gv->isConst()});
+    c = ConcreteVal::mkPtr(init_mem.size() - 1, 0);
+  } else {
+    return false;
+  }
+
+  slots.emplace(&v, init_regs.size());
+  init_regs.emplace_back(c);
+  return true;
+}
+
+bool Interpreter::checkSupport() {
+  auto fail = [&](const string &what, const Value &v) {
+    ostringstream os;
+    os << what << ": ";
+    v.print(os);
+    unsupported_reason = std::move(os).str();
+    return false;
+  };
+
+  if (!f.isLittleEndian()) {
+    unsupported_reason = "big-endian data layout";
+    return false;
+  }
+  if (f.isVarArgs()) {
+    unsupported_reason = "variadic function";
+    return false;
+  }
+  if (!supported_type(f.getType())) {
+    unsupported_reason = "return type";
+    return false;
+  }
+
+  for (auto &in : f.getInputs()) {
+    if (!in.getType().isIntType() || in.getType().bits() > 64)
+      return fail("unsupported argument", in);
+    slots.emplace(&in, init_regs.size());
+    init_regs.emplace_back();
+  }
+
+  for (auto bb : f.getBBs()) {
+    for (auto &i : bb->instrs()) {
+      slots.emplace(&i, init_regs.size());
+      init_regs.emplace_back();
+    }
+  }
+
+  operands.resize(init_regs.size());
+
+  for (auto bb : f.getBBs()) {
+    for (auto &i : bb->instrs()) {
+      if (!supported_type(i.getType()) || !supported_instr(i))
+        return fail("unsupported instruction", i);
+
+      auto &ops = operands[slots.at(&i)];
+      for (auto *op : i.operands()) {
+        if (!supported_type(op->getType()) ||
+            (!slots.count(op) && !addConstant(*op)))
+          return fail("unsupported value", *op);
+        ops.push_back({slots.at(op), width(op->getType())});
+      }
+    }
+  }
+  return true;
+}
+
+Interpreter::Block& Interpreter::access(const ConcreteVal &ptr, uint64_t size,
+                                        uint64_t align, bool store) {
+  if (ptr.poison || ptr.undef || ptr.bid == 0)
+    ub();
+
+  auto &blk = mem[ptr.bid];
+  int64_t offset = ptr.bits;
+  // Blocks are assumed to be placed at sufficiently aligned addresses.
+  if (!blk.alive || (store && blk.readonly && !initializing) || offset < 0 ||
+      ptr.bits + size > blk.bytes.size() || (align && ptr.bits % align))
+    ub();
+  return blk;
+}
+
+ConcreteVal Interpreter::load(const Type &ty, const ConcreteVal &ptr,
+                              uint64_t align) {
+  bool is_ptr = ty.isPtrType();
+  unsigned bits = width(ty);
+  uint64_t size = is_ptr ? ptr_bytes : (bits + 7) / 8;
+  auto *bytes = &access(ptr, size, align, false).bytes[ptr.bits];
+
+  if (is_ptr) {
+    for (unsigned i = 0; i < size; ++i) {
+      auto &b = bytes[i];
+      if (b.kind == Byte::Int)
+        not_supported("load of a pointer from integer bytes");
+      if (b.kind == Byte::Poison || b.val != i || b.bid != bytes[0].bid ||
+          b.offset != bytes[0].offset)
+        return ConcreteVal::mkPoison(true);
+    }
+    return ConcreteVal::mkPtr(bytes[0].bid, bytes[0].offset);
+  }
+
+  uint64_t n = 0;
+  for (unsigned i = 0; i < size; ++i) {
+    auto &b = bytes[i];
+    if (b.kind == Byte::Ptr)
+      not_supported("load of an integer from pointer bytes");
+    if (b.kind == Byte::Poison)
+      return ConcreteVal::mkPoison(false);
+    n |= (uint64_t)b.val << (8 * i);
+  }
+  return ConcreteVal::mkInt(n & mask(bits));
+}
+
+void Interpreter::store(const Type &ty, const ConcreteVal &val,
+                        const ConcreteVal &ptr, uint64_t align) {
+  bool is_ptr = ty.isPtrType();
+  uint64_t size = is_ptr ? ptr_bytes : (width(ty) + 7) / 8;
+  auto *bytes = &access(ptr, size, align, true).bytes[ptr.bits];
+  auto v = resolve(val);
+
+  for (unsigned i = 0; i < size; ++i) {
+    auto &b = bytes[i];
+    b = Byte();
+    if (v.poison)
+      continue;
+    if (is_ptr) {
+      b.kind   = Byte::Ptr;
+      b.val    = i;
+      b.bid    = v.bid;
+      b.offset = v.bits;
+    } else {
+      b.kind = Byte::Int;
+      b.val  = v.bits >> (8 * i);
+    }
+  }
+}
+
+ConcreteVal Interpreter::exec(const Instr &i) {
+  auto &ops = operands[slots.at(&i)];
+  auto op = [&](unsigned idx) -> const ConcreteVal& {
+    return regs[ops[idx].slot];
+  };
+  bool is_ptr = i.getType().isPtrType();
+
+  if (auto *bop = dynamic_cast<const BinOp*>(&i))
+    return binop(*bop, op(0), op(1), ops[0].bits);
+
+  if (auto *uop = dynamic_cast<const UnaryOp*>(&i))
+    return unop(*uop, op(0), ops[0].bits);
+
+  if (auto *conv = dynamic_cast<const ConversionOp*>(&i))
+    return conversion(*conv, op(0), ops[0].bits, width(i.getType()));
+
+  if (auto *cmp = dynamic_cast<const ICmp*>(&i)) {
+    if (op(0).poison || op(1).poison)
+      return ConcreteVal::mkPoison(false);
+    auto a = resolve(op(0)), b = resolve(op(1));
+    auto cond = cmp->getCond();
+
+    if (a.is_ptr) {
+      // the addresses of different blocks are unknown; they may even be
+      // equal, e.g., one past the end of a block and the start of another
+      if (a.bid != b.bid && cmp->getPtrCmpMode() != ICmp::OFFSETONLY)
+        not_supported("comparison of pointers to different blocks");
+      return ConcreteVal::mkInt(icmp(cond, a.bits, b.bits, 64));
+    }
+
+    if ((cmp->getFlags() & ICmp::SameSign) &&
+        (sext(a.bits, ops[0].bits) < 0) != (sext(b.bits, ops[0].bits) < 0))
+      return ConcreteVal::mkPoison(false);
+    return ConcreteVal::mkInt(icmp(cond, a.bits, b.bits, ops[0].bits));
+  }
+
+  if (dynamic_cast<const Select*>(&i)) {
+    if (op(0).poison)
+      return ConcreteVal::mkPoison(is_ptr);
+    return resolve(op(0)).bits ? op(1) : op(2);
+  }
+
+  if (dynamic_cast<const Freeze*>(&i)) {
+    auto v = op(0);
+    if (v.poison)
+      return is_ptr ? ConcreteVal::mkPtr(0, 0) : ConcreteVal::mkInt(0);
+    return resolve(v);
+  }
+
+  if (auto *alloc = dynamic_cast<const Alloc*>(&i)) {
+    auto size = op(0);
+    if (size.poison || size.undef)
+      ub();
+    uint64_t bytes = size.bits;
+    if (alloc->getMul()) {
+      auto mul = op(1);
+      if (mul.poison || mul.undef || __builtin_mul_overflow(bytes, mul.bits,
+                                                            &bytes))
+        ub();
+    }
+    // Allocations larger than this would not fit in memory anyway.
+    if (bytes > (1ull << 32))
+      not_supported("allocation too large");
+
+    mem.emplace_back(Block{vector<Byte>(bytes), num_locals++, true,
+                           !alloc->initDead()});
+    return ConcreteVal::mkPtr(mem.size() - 1, 0);
+  }
+
+  if (dynamic_cast<const StartLifetime*>(&i) ||
+      dynamic_cast<const EndLifetime*>(&i)) {
+    auto ptr = op(0);
+    if (ptr.poison || ptr.undef || ptr.bid == 0 || !mem[ptr.bid].local)
+      ub();
+    auto &blk = mem[ptr.bid];
+    blk.alive = dynamic_cast<const StartLifetime*>(&i) != nullptr;
+    if (blk.alive)
+      fill(blk.bytes.begin(), blk.bytes.end(), Byte());
+    return {};
+  }
+
+  if (auto *gep = dynamic_cast<const GEP*>(&i)) {
+    auto ptr = resolve(op(0));
+    if (ptr.poison)
+      return ptr;
+
+    auto block_size = (int64_t)mem[ptr.bid].bytes.size();
+    auto inbounds = [&](int64_t offset) {
+      return offset >= 0 && offset <= block_size;
+    };
+    int64_t offset = ptr.bits, offset_sum = 0;
+    bool np = true, all_zeros = true, in_bounds = inbounds(offset);
+    bool nusw = gep->hasNoUnsignedSignedWrap(), nuw = gep->hasNoUnsignedWrap();
+
+    // Same conditions as GEP::toSMT. Without inbounds, nusw and nuw also
+    // constrain the address, which isn't known concretely.
+    unsigned idx = 1;
+    for (auto &[sz, val] : gep->getIdxs()) {
+      auto &v = op(idx);
+      unsigned bits = ops[idx++].bits;
+      if (v.poison)
+        return ConcreteVal::mkPoison(true);
+      int64_t n = sext(resolve(v).bits, bits), inc, tmp;
+      uint64_t uinc, utmp;
+
+      if (nusw) {
+        np &= !__builtin_mul_overflow((int64_t)sz, n, &inc);
+        if (gep->isInBounds()) {
+          np &= !__builtin_add_overflow(offset, inc, &tmp);
+        } else {
+          np &= !__builtin_add_overflow(offset_sum, inc, &offset_sum);
+          if (inc != 0)
+            not_supported("gep nusw without inbounds");
+        }
+      }
+
+      if (nuw) {
+        // the index is zero-extended
+        np &= bits >= 64 || n >= 0;
+        np &= !__builtin_mul_overflow(sz, (uint64_t)n, &uinc);
+        if (gep->isInBounds()) {
+          np &= !__builtin_add_overflow((uint64_t)offset, uinc, &utmp);
+        } else if (uinc != 0) {
+          not_supported("gep nuw without inbounds");
+        }
+      }
+
+      inc = (int64_t)(sz * (uint64_t)n);
+      all_zeros &= sz == 0 || n == 0;
+      offset = (int64_t)((uint64_t)offset + (uint64_t)inc);
+      in_bounds &= inbounds(offset);
+    }
+
+    if (gep->isInBounds() && !all_zeros && !in_bounds)
+      np = false;
+    return np ? ConcreteVal::mkPtr(ptr.bid, offset)
+              : ConcreteVal::mkPoison(true);
+  }
+
+  if (auto *ld = dynamic_cast<const Load*>(&i))
+    return load(i.getType(), op(0), ld->getAlign());
+
+  if (auto *st = dynamic_cast<const Store*>(&i)) {
+    store(st->getValue().getType(), op(0), op(1), st->getAlign());
+    return {};
+  }
+
+  if (auto *assume = dynamic_cast<const Assume*>(&i)) {
+    auto &cond = op(0);
+    if (cond.poison ||
+        (assume->getKind() == Assume::AndNonPoison && !resolve(cond).bits))
+      ub();
+    return {};
+  }
+
+  not_supported("instruction");
+}
+
+const BasicBlock* Interpreter::jump(const Instr &i) {
+  auto &ops = operands[slots.at(&i)];
+
+  if (auto *br = dynamic_cast<const Branch*>(&i)) {
+    if (!br->getCond())
+      return &br->getTrue();
+
+    auto &cond = regs[ops[0].slot];
+    // branching on undef is UB as well
+    if (cond.poison || cond.undef)
+      ub();
+    return cond.bits ? &br->getTrue() : br->getFalse();
+  }
+
+  auto &sw = static_cast<const Switch&>(i);
+  auto &val = regs[ops[0].slot];
+  if (val.poison || val.undef)
+    ub();
+
+  for (unsigned idx = 0, e = sw.getNumTargets(); idx != e; ++idx) {
+    if (regs[ops[idx + 1].slot].bits == val.bits)
+      return sw.getTarget(idx).second;
+  }
+  return sw.getDefault();
+}
+
+Interpreter::Result
+Interpreter::run(const vector<ConcreteVal> &args, ostream *trace) {
+  if (!unsupported_reason.empty())
+    return { Unsupported, {}, unsupported_reason };
+
+  regs = init_regs;
+  mem  = init_mem;
+  num_locals = 0;
+
+  unsigned argn = 0;
+  for (auto &in : f.getInputs()) {
+    auto v = argn < args.size() ? args[argn] : ConcreteVal();
+    v.bits &= mask(width(in.getType()));
+    regs[slots.at(&in)] = v;
+    ++argn;
+  }
+
+  auto print_val = [&](const Instr &i) {
+    auto &name = i.getName();
+    *trace << name;
+    if (name[0] == '%') {
+      *trace << " = ";
+      print(*trace, regs[slots.at(&i)], i.getType());
+    }
+    *trace << '\n';
+  };
+
+  const BasicBlock *bb = entry, *pred = nullptr;
+  const Instr *current = nullptr;
+
+  try {
+    while (true) {
+      if (trace)
+        *trace << "Executing " << bb->getName() << '\n';
+
+      // phis read their operands simultaneously on entry
+      vector<pair<unsigned, ConcreteVal>> phi_vals;
+      auto I = bb->instrs().begin(), E = bb->instrs().end();
+      for (; I != E; ++I) {
+        auto *phi = dynamic_cast<const Phi*>(&*I);
+        if (!phi)
+          break;
+
+        unsigned slot = slots.at(phi), idx = 0;
+        for (auto &[val, pred_bb] : phi->getValues()) {
+          if (pred && pred_bb == pred->getName())
+            break;
+          ++idx;
+        }
+        if (idx == phi->getValues().size())
+          not_supported("phi without a value for the predecessor");
+        phi_vals.emplace_back(slot, regs[operands[slot][idx].slot]);
+      }
+      for (auto &[slot, v] : phi_vals) {
+        regs[slot] = v;
+      }
+      if (trace) {
+        for (auto II = bb->instrs().begin(); II != I; ++II) {
+          print_val(*II);
+        }
+      }
+
+      const BasicBlock *next = nullptr;
+      for (; I != E; ++I) {
+        auto &i = *I;
+        current = &i;
+
+        if (dynamic_cast<const Return*>(&i)) {
+          auto &ret = regs[operands[slots.at(&i)][0].slot];
+          return { Returned, ret, {} };
+        }
+
+        if (dynamic_cast<const JumpInstr*>(&i)) {
+          next = jump(i);
+          if (trace)
+            *trace << "  >> Jump to " << next->getName() << "\n\n";
+          break;
+        }
+
+        regs[slots.at(&i)] = exec(i);
+        if (trace)
+          print_val(i);
+      }
+
+      if (!next)
+        not_supported("basic block without terminator");
+      pred = bb;
+      bb   = next;
+    }
+  } catch (const Stop &s) {
+    return { s.status, {},
+             s.status == UB && current ? current->getName() : s.msg };
+  }
+  UNREACHABLE();
+}
+
+void Interpreter::print(ostream &os, const ConcreteVal &v,
+                        const Type &ty) const {
+  if (v.poison) {
+    os << "poison";
+    return;
+  }
+  if (v.undef) {
+    os << "undef";
+    return;
+  }
+  if (ty.isVoid()) {
+    os << "void";
+    return;
+  }
+
+  if (v.is_ptr) {
+    if (v.bid == 0) {
+      if (v.bits == 0) {
+        os << "null";
+        return;
+      }
+      os << "pointer(non-local, block_id=0, offset=" << (int64_t)v.bits << ')';
+      return;
+    }
+    auto &blk = mem[v.bid];
+    os << "pointer(" << (blk.local ? "local" : "non-local")
+       << ", block_id=" << blk.short_bid
+       << ", offset=" << (int64_t)v.bits << ')';
+    return;
+  }
+
+  // same format as Z3 uses for bit-vectors
+  unsigned bits = width(ty);
+  if (bits % 4 == 0) {
+    static const char digits[] = "0123456789abcdef";
+    os << "#x";
+    for (unsigned i = bits / 4; i > 0; --i) {
+      os << digits[(v.bits >> ((i - 1) * 4)) & 0xf];
+    }
+  } else {
+    os << "#b";
+    for (unsigned i = bits; i > 0; --i) {
+      os << ((v.bits >> (i - 1)) & 1);
+    }
+  }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace IR {
+class BasicBlock;
+class Function;
+class Instr;
+class Type;
+class Value;
+}
+
+namespace tools {
+
+/// A concrete scalar: either an integer of at most 64 bits or a logical
+/// pointer (block id + offset). Undef is only resolved when it is used.
+struct ConcreteVal {
+  uint64_t bits = 0; // the integer, or the offset of a pointer
+  unsigned bid = 0;  // block of a pointer; 0 is the null block
+  bool is_ptr = false;
+  bool poison = false;
+  bool undef = false;
+
+  static ConcreteVal mkInt(uint64_t n);
+  static ConcreteVal mkPtr(unsigned bid, int64_t offset);
+  static ConcreteVal mkPoison(bool is_ptr);
+  static ConcreteVal mkUndef(bool is_ptr);
+};
+
+
+/// Runs an IR::Function over concrete values without querying the SMT solver.
+/// Memory is byte-addressed like IR::Memory: every byte is either poison,
+/// an integer byte, or a fragment of a pointer.
+/// Functions using features without a concrete implementation (floats,
+/// aggregates, calls, ...) are rejected upfront via unsupported(), and any
+/// corner case found while running yields an Unsupported result, so that
+/// callers can fall back to symbolic execution.
+class Interpreter {
+public:
+  enum Status { Returned, UB, Unsupported };
+
+  struct Result {
+    Status status;
+    ConcreteVal val;
+    std::string msg; // the instruction triggering UB or the unsupported case
+  };
+
+private:
+  struct Byte {
+    enum Kind : uint8_t { Poison, Int, Ptr } kind = Poison;
+    uint8_t val = 0; // integer byte, or index of the pointer fragment
+    unsigned bid = 0;
+    uint64_t offset = 0;
+  };
+
+  struct Block {
+    std::vector<Byte> bytes;
+    unsigned short_bid;
+    bool local;
+    bool alive = true;
+    bool readonly = false;
+  };
+
+  struct Operand {
+    unsigned slot;
+    unsigned bits; // 0 for pointers
+  };
+
+  const IR::Function &f;
+  const IR::BasicBlock *entry = nullptr;
+  std::string unsupported_reason;
+  unsigned ptr_bytes;
+  unsigned num_nonlocals = 0;
+  bool initializing = false;
+
+  // Every input, instruction, and constant gets a register slot.
+  std::unordered_map<const IR::Value*, unsigned> slots;
+  std::vector<std::vector<Operand>> operands; // indexed by instruction slot
+  std::vector<ConcreteVal> init_regs, regs;
+  std::vector<Block> init_mem, mem;
+  unsigned num_locals = 0;
+
+  bool checkSupport();
+  bool addConstant(const IR::Value &v);
+
+  Block& access(const ConcreteVal &ptr, uint64_t size, uint64_t align,
+                bool store);
+  ConcreteVal load(const IR::Type &ty, const ConcreteVal &ptr,
+                   uint64_t align);
+  void store(const IR::Type &ty, const ConcreteVal &val,
+             const ConcreteVal &ptr, uint64_t align);
+
+  ConcreteVal exec(const IR::Instr &i);
+  const IR::BasicBlock* jump(const IR::Instr &i);
+
+public:
+  Interpreter(const IR::Function &f);
+
+  // Empty if the function can be executed concretely.
+  const std::string& unsupported() const { return unsupported_reason; }
+
+  // Runs the function with the given integer arguments. Missing arguments
+  // default to zero. The trace mimics the output of alive-exec.
+  Result run(const std::vector<ConcreteVal> &args,
+             std::ostream *trace = nullptr);
+
+  void print(std::ostream &os, const ConcreteVal &v,
+             const IR::Type &ty) const;
+};
+
+}
@@ -5,8 +5,10 @@
 #include "llvm_util/compare.h"
 #include "llvm_util/llvm2alive.h"
 #include "llvm_util/llvm_optimizer.h"
+#include "llvm_util/utils.h"
 #include "smt/smt.h"
 #include "tools/transform.h"
+#include "util/parallel.h"
 #include "util/version.h"
 
 #include "llvm/ADT/StringExtras.h"
@@ -14,6 +16,7 @@
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -21,7 +24,9 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/InitializePasses.h"
 #include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/TargetParser/Triple.h"
@@ -29,11 +34,16 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <random>
+#include <set>
 #include <sstream>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <utility>
 
 using namespace tools;
@@ -95,6 +105,22 @@ cl::opt<string>
                      "https://llvm.org/docs/NewPassManager.html#invoking-opt"),
             cl::cat(alive_cmdargs), cl::init("O2"));
 
+cl::opt<string> opt_corpus(
+    LLVM_ARGS_PREFIX "corpus", cl::value_desc("directory"),
+    cl::desc("Keep a corpus of interesting functions in this directory and "
+             "mutate them instead of always generating new ones. A function "
+             "is interesting if it makes a new LLVM pass change the code or "
+             "triggers a new kind of Alive2 query. The features seen so far "
+             "are recorded in the directory's .features subdirectory, which "
+             "is shared by the -j workers and later runs (default=disabled)"),
+    cl::cat(alive_cmdargs));
+
+cl::opt<unsigned> opt_jobs(
+    LLVM_ARGS_PREFIX "j",
+    cl::desc("Number of worker processes; each one fuzzes a disjoint range of "
+             "the repetitions (default=1)"),
+    cl::Prefix, cl::value_desc("N"), cl::cat(alive_cmdargs), cl::init(1));
+
 class Chooser {
   mt19937_64 Rand;
   Chooser() = delete;
@@ -884,43 +910,361 @@ void BBFuzzer::go() {
   }
 }
 
-} // namespace
 
-int main(int argc, char **argv) {
-  sys::PrintStackTraceOnErrorSignal(argv[0]);
-  llvm::InitLLVM X(argc, argv);
-  EnableDebugBuffering = true;
-  LLVMContext Context;
+// Mutates the function "f" of a module in place: inserts, deletes or retypes
+// instructions, changes flags and predicates, and tweaks constants.
+class Mutator {
+  Function &F;
+  Chooser C;
 
-  string Usage =
-      R"EOF(Alive2 simple generative fuzzer:
-version )EOF";
-  Usage += alive_version;
-  Usage += R"EOF(
-see quick-fuzz --version for LLVM version info,
+  template <typename T>
+  T& pick(vector<T> &v) {
+    return v[C.choose(v.size())];
+  }
 
-This program stress-tests LLVM and Alive2 by performing randomized
-generation of LLVM functions, optimizing them, and then checking
-refinement.
+  vector<Instruction *> candidates(function<bool(Instruction &)> pred) {
+    vector<Instruction *> v;
+    for (auto &I : instructions(F)) {
+      if (pred(I))
+        v.push_back(&I);
+    }
+    return v;
+  }
 
-It currently contains two simple generators: "value," which generates
-a single basic block containing integer operations, and "bb," which
-exercises loop and control flow optimizations.
+  APInt mutateInt(APInt I) {
+    auto Width = I.getBitWidth();
+    switch (C.choose(6)) {
+    case 0:
+      I += APInt(Width, 1 + C.choose(8));
+      break;
+    case 1:
+      I -= APInt(Width, 1 + C.choose(8));
+      break;
+    case 2:
+      I.flipBit(C.choose(Width));
+      break;
+    case 3:
+      I.negate();
+      break;
+    case 4:
+      I = C.flip() ? APInt::getSignedMinValue(Width)
+                   : APInt::getSignedMaxValue(Width);
+      break;
+    case 5:
+      I = C.flip() ? APInt::getZero(Width) : APInt::getAllOnes(Width);
+      break;
+    default:
+      assert(false);
+    }
+    return I;
+  }
 
-The recommended workflow is to run quick-fuzz until it finds an issue,
-and then re-run with the same seed and also the --save-ir command line
-option, in order to get a standalone test case that can then be
-reduced using llvm-reduce.
-)EOF";
+  Value *intCast(Value *V, Type *Ty, Instruction *Before) {
+    return CastInst::CreateIntegerCast(V, Ty, C.flip(), "", Before);
+  }
 
-  cl::HideUnrelatedOptions(alive_cmdargs);
-  cl::ParseCommandLineOptions(argc, argv, Usage);
+  // insert a binop on the result of an instruction and use it in place of
+  // some of the instruction's uses
+  bool insertInst() {
+    auto Cands = candidates([](Instruction &I) {
+      return I.getType()->isIntegerTy() && !I.isTerminator();
+    });
+    if (Cands.empty())
+      return false;
+
+    auto *I = pick(Cands);
+    auto *Before = isa<PHINode>(I) ? &*I->getParent()->getFirstInsertionPt()
+                                   : I->getNextNode();
+    static const Instruction::BinaryOps Ops[] = {
+      Instruction::Add, Instruction::Sub, Instruction::Mul,
+      Instruction::UDiv, Instruction::SDiv, Instruction::URem,
+      Instruction::SRem, Instruction::Shl, Instruction::LShr,
+      Instruction::AShr, Instruction::And, Instruction::Or, Instruction::Xor
+    };
+    Value *K = ConstantInt::get(I->getType(),
+                                mutateInt(APInt::getZero(
+                                  I->getType()->getIntegerBitWidth())));
+    bool swap = C.flip();
+    auto *New = BinaryOperator::Create(Ops[C.choose(size(Ops))],
+                                       swap ? K : I, swap ? I : K, "", Before);
+    I->replaceUsesWithIf(New, [&](Use &U) {
+      return U.getUser() != New && C.choose(4) != 0;
+    });
+    return true;
+  }
 
-  unique_ptr<Cache> cache;
-  unique_ptr<Module> MDummy;
-#define ARGS_MODULE_VAR MDummy
-#include "llvm_util/cmd_args_def.h"
+  // replace the uses of an instruction with one of its operands or with a
+  // constant and remove it
+  bool deleteInst() {
+    auto Cands = candidates([](Instruction &I) {
+      return I.getType()->isIntegerTy() && !I.isTerminator() &&
+             !isa<PHINode>(I) && !I.mayHaveSideEffects();
+    });
+    if (Cands.empty())
+      return false;
+
+    auto *I = pick(Cands);
+    vector<Value *> Repls;
+    for (auto &Op : I->operands()) {
+      if (Op->getType() == I->getType())
+        Repls.push_back(Op);
+    }
+    auto *Repl = Repls.empty()
+                   ? ConstantInt::get(I->getType(),
+                       mutateInt(APInt::getZero(
+                         I->getType()->getIntegerBitWidth())))
+                   : pick(Repls);
+    I->replaceAllUsesWith(Repl);
+    I->eraseFromParent();
+    return true;
+  }
+
+  // perform a binop or icmp at a different width
+  bool retypeInst() {
+    auto Cands = candidates([](Instruction &I) {
+      return (isa<BinaryOperator>(I) && I.getType()->isIntegerTy()) ||
+             isa<ICmpInst>(I);
+    });
+    if (Cands.empty())
+      return false;
+
+    auto *I = pick(Cands);
+    auto *OpTy = I->getOperand(0)->getType();
+    if (!OpTy->isIntegerTy())
+      return false;
+
+    unsigned Width = OpTy->getIntegerBitWidth(), NewWidth;
+    do {
+      NewWidth = C.flip() ? 1 + C.choose(64) : 8 << C.choose(4);
+    } while (NewWidth == Width);
+    auto *NewTy = Type::getIntNTy(F.getContext(), NewWidth);
+
+    auto *LHS = intCast(I->getOperand(0), NewTy, I);
+    auto *RHS = intCast(I->getOperand(1), NewTy, I);
+    Value *New;
+    if (auto *Cmp = dyn_cast<ICmpInst>(I)) {
+      New = new ICmpInst(I, Cmp->getPredicate(), LHS, RHS);
+    } else {
+      auto *BO = BinaryOperator::Create(cast<BinaryOperator>(I)->getOpcode(),
+                                        LHS, RHS, "", I);
+      BO->copyIRFlags(I);
+      New = intCast(BO, I->getType(), I);
+    }
+    I->replaceAllUsesWith(New);
+    I->eraseFromParent();
+    return true;
+  }
+
+  bool changeFlags() {
+    auto Cands = candidates([](Instruction &I) {
+      return isa<OverflowingBinaryOperator>(I) ||
+             isa<PossiblyExactOperator>(I) || isa<ICmpInst>(I);
+    });
+    if (Cands.empty())
+      return false;
+
+    auto *I = pick(Cands);
+    if (auto *Cmp = dyn_cast<ICmpInst>(I)) {
+      Cmp->setPredicate(C.flip() ? Cmp->getInversePredicate()
+                                 : Cmp->getSwappedPredicate());
+    } else if (isa<OverflowingBinaryOperator>(I)) {
+      if (C.flip())
+        I->setHasNoSignedWrap(!I->hasNoSignedWrap());
+      else
+        I->setHasNoUnsignedWrap(!I->hasNoUnsignedWrap());
+    } else {
+      I->setIsExact(!I->isExact());
+    }
+    return true;
+  }
+
+  bool changeConstant() {
+    vector<pair<Instruction *, unsigned>> Cands;
+    for (auto &I : instructions(F)) {
+      // calls may require immediate arguments, and switch cases and alloca
+      // sizes are better left alone
+      if (isa<CallBase>(I) || isa<SwitchInst>(I) || isa<AllocaInst>(I) ||
+          isa<GetElementPtrInst>(I))
+        continue;
+      for (unsigned i = 0, e = I.getNumOperands(); i != e; ++i) {
+        if (isa<ConstantInt>(I.getOperand(i)))
+          Cands.emplace_back(&I, i);
+      }
+    }
+    if (Cands.empty())
+      return false;
+
+    auto [I, Idx] = pick(Cands);
+    auto *K = cast<ConstantInt>(I->getOperand(Idx));
+    I->setOperand(Idx, ConstantInt::get(K->getType(),
+                                        mutateInt(K->getValue())));
+    return true;
+  }
+
+public:
+  Mutator(Function &F, long seed) : F(F), C(seed) {}
+
+  // returns false if no mutation could be applied
+  bool mutate() {
+    unsigned num = 1 + C.choose(3), done = 0;
+    for (unsigned tries = 0; done < num && tries < 20; ++tries) {
+      bool ok = false;
+      switch (C.choose(5)) {
+      case 0:
+        ok = insertInst();
+        break;
+      case 1:
+        ok = deleteInst();
+        break;
+      case 2:
+        ok = retypeInst();
+        break;
+      case 3:
+        ok = changeFlags();
+        break;
+      case 4:
+        ok = changeConstant();
+        break;
+      default:
+        assert(false);
+      }
+      done += ok;
+    }
+    return done > 0;
+  }
+};
+
+// The corpus of functions whose optimization or verification exercised
+// something new.
+class Corpus {
+  LLVMContext &Ctx;
+  vector<unique_ptr<Module>> Modules;
+  set<string> Features;
+  unsigned Added = 0;
+
+public:
+  Corpus(LLVMContext &Ctx) : Ctx(Ctx) {}
+
+  void load(const string &Dir) {
+    error_code EC;
+    sys::fs::create_directories(Dir + "/.features");
+    for (sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC;
+         I.increment(EC)) {
+      auto Ext = sys::path::extension(I->path());
+      if (Ext != ".ll" && Ext != ".bc")
+        continue;
+      SMDiagnostic Err;
+      auto M = parseIRFile(I->path(), Err, Ctx);
+      if (!M || !M->getFunction("f") || M->getFunction("f")->isDeclaration()) {
+        *out << "skipping corpus file '" << I->path() << "'\n";
+        continue;
+      }
+      Modules.push_back(std::move(M));
+    }
+  }
+
+  bool empty() const { return Modules.empty(); }
+  unsigned numAdded() const { return Added; }
+
+  unique_ptr<Module> pick(Chooser &C) const {
+    return CloneModule(*Modules[C.choose(Modules.size())]);
+  }
+
+  // Whether F hasn't been seen before by any worker. Each feature has a
+  // marker file, and only the worker that creates it gets to add a function.
+  bool isNew(const string &F) {
+    if (!Features.insert(F).second)
+      return false;
+
+    string Name = F;
+    std::replace(Name.begin(), Name.end(), '/', '_');
+    int FD;
+    auto EC = sys::fs::openFileForWrite(opt_corpus + "/.features/" + Name, FD,
+                                        sys::fs::CD_CreateNew);
+    if (EC == std::errc::file_exists)
+      return false;
+    if (!EC)
+      close(FD);
+    return true;
+  }
+
+  // Adds M to the corpus if any of the features hasn't been seen before.
+  void add(const Module &M, const set<string> &NewFeatures, long seed) {
+    bool interesting = false;
+    for (auto &F : NewFeatures) {
+      interesting |= isNew(F);
+    }
+    if (!interesting)
+      return;
+
+    Modules.push_back(CloneModule(M));
+    ++Added;
+
+    auto Path = opt_corpus + "/fuzz-" + to_string((unsigned long)seed) + ".ll";
+    error_code EC;
+    raw_fd_ostream File(Path, EC);
+    if (EC) {
+      *out << "Couldn't save corpus file '" << Path << "'\n";
+      return;
+    }
+    M.print(File, nullptr);
+  }
+};
+
+struct FuzzStats {
+  unsigned num_correct = 0;
+  unsigned num_unsound = 0;
+  unsigned num_failed = 0;
+  unsigned num_errors = 0;
+  unsigned corpus_added = 0;
+
+  void update(const Verifier &verifier, const Corpus &corpus) {
+    num_correct = verifier.num_correct;
+    num_unsound = verifier.num_unsound;
+    num_failed = verifier.num_failed;
+    num_errors = verifier.num_errors;
+    corpus_added = corpus.numAdded();
+  }
+
+  FuzzStats& operator+=(const FuzzStats &other) {
+    num_correct += other.num_correct;
+    num_unsound += other.num_unsound;
+    num_failed += other.num_failed;
+    num_errors += other.num_errors;
+    corpus_added += other.corpus_added;
+    return *this;
+  }
+};
+
+enum class FuzzStatus { Done, Stopped, BadPasses };
+
+// Memory that remains shared with the worker processes forked afterwards.
+template <typename T>
+T* allocShared(size_t n) {
+  void *p = mmap(nullptr, sizeof(T) * n, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap() failed");
+    exit(-1);
+  }
+  auto *arr = static_cast<T*>(p);
+  for (size_t i = 0; i < n; ++i) {
+    new (&arr[i]) T();
+  }
+  return arr;
+}
 
+// Runs repetitions [first, last). The seed of each repetition is the one
+// a sequential run would use, so the results don't depend on -j.
+// Stops early, and sets stop, if a transformation fails with -error-fatal.
+// Functions found to be miscompiled are saved as unsound_<rep>.ll.
+// A worker (parallelMgr != nullptr) sends its output to the parent after
+// each repetition.
+FuzzStatus fuzz(const function<unique_ptr<Fuzzer>(Module &, long)> &makeFuzzer,
+                int first, int last, unsigned long main_seed,
+                FuzzStats &stats, atomic<bool> &stop,
+                parallel *parallelMgr = nullptr) {
+  LLVMContext Context;
   Module M1("fuzz", Context);
   auto &DL = M1.getDataLayout();
   Triple targetTriple(M1.getTargetTriple());
@@ -933,38 +1277,52 @@ reduced using llvm-reduce.
   verifier.print_dot = opt_print_dot;
   verifier.bidirectional = opt_bidirectional;
 
-  function<unique_ptr<Fuzzer>(Module &, long)> makeFuzzer;
-  if (opt_fuzzer == "value") {
-    makeFuzzer = [](Module &M, long seed) {
-      return make_unique<ValueFuzzer>(M, seed);
-    };
-  } else if (opt_fuzzer == "bb") {
-    makeFuzzer = [](Module &M, long seed) {
-      return make_unique<BBFuzzer>(M, seed);
-    };
-  } else {
-    *out << "Available fuzzers are \"value\" and \"bb\".\n\n";
-    exit(-1);
-  }
+  Corpus corpus(Context);
+  if (!opt_corpus.empty())
+    corpus.load(opt_corpus);
 
-  mt19937_64 Rand((opt_rand_seed == 0) ? random_device{}() : opt_rand_seed);
+  mt19937_64 Rand(main_seed);
   uniform_int_distribution<unsigned long> Dist(
       0, numeric_limits<unsigned long>::max());
+  // skip the seeds of the repetitions run by other workers
+  for (int rep = 0; rep < first; ++rep)
+    Dist(Rand);
+
+  for (int rep = first; rep < last; ++rep) {
+    if (parallelMgr && rep != first)
+      parallelMgr->flushChild();
+
+    if (stop)
+      return FuzzStatus::Stopped;
+
+    long seed = Dist(Rand);
+    Chooser C(seed);
+
+    // mutate a corpus entry 3 times out of 4, else generate a new function
+    unique_ptr<Module> Mutated;
+    if (!corpus.empty() && C.choose(4) != 0) {
+      Mutated = corpus.pick(C);
+      if (!Mutator(*Mutated->getFunction("f"), C.dist()).mutate() ||
+          verifyModule(*Mutated))
+        Mutated.reset();
+    }
 
-  for (int rep = 0; rep < opt_num_reps; ++rep) {
-    auto F = makeFuzzer(M1, Dist(Rand));
-    F->go();
+    if (!Mutated) {
+      auto F = makeFuzzer(M1, seed);
+      F->go();
 
-    if (verifyModule(M1, &errs()))
-      report_fatal_error("Broken module found, this should not happen");
+      if (verifyModule(M1, &errs()))
+        report_fatal_error("Broken module found, this should not happen");
+    }
+    Module &M = Mutated ? *Mutated : M1;
 
     if (opt_run_sroa) {
-      auto err = optimize_module(&M1, "sroa,dse");
+      auto err = optimize_module(&M, "sroa,dse");
       assert(err.empty());
     }
 
     if (opt_run_dce) {
-      auto err = optimize_module(&M1, "adce");
+      auto err = optimize_module(&M, "adce");
       assert(err.empty());
     }
 
@@ -976,13 +1334,13 @@ reduced using llvm-reduce.
       raw_fd_ostream output_file(output_fn.str(), EC);
       if (EC)
         report_fatal_error("Couldn't open output file, exiting");
-      WriteBitcodeToFile(M1, output_file);
+      WriteBitcodeToFile(M, output_file);
     }
 
     if (opt_print_ir) {
       out->flush();
       outs() << "------------------------------------------------------\n\n";
-      M1.print(outs(), nullptr);
+      M.print(outs(), nullptr);
       outs() << "------------------------------------------------------\n\n";
       outs().flush();
     }
@@ -990,14 +1348,16 @@ reduced using llvm-reduce.
     if (opt_skip_alive)
       continue;
 
-    auto M2 = CloneModule(M1);
-    auto err = optimize_module(M2.get(), optPass);
+    set<string> changed_passes, queries;
+    auto M2 = CloneModule(M);
+    auto err = optimize_module(M2.get(), optPass,
+                               opt_corpus.empty() ? nullptr : &changed_passes);
     if (!err.empty()) {
       *out << "Error parsing list of LLVM passes: " << err << '\n';
-      return -1;
+      return FuzzStatus::BadPasses;
     }
 
-    auto *F1 = M1.getFunction("f");
+    auto *F1 = M.getFunction("f");
     auto *F2 = M2->getFunction("f");
     assert(F1 && F2);
 
@@ -1008,9 +1368,41 @@ reduced using llvm-reduce.
     F2->removeFnAttr(Attribute::Memory);
     F2->removeFnAttr(Attribute::WillReturn);
 
-    if (!verifier.compareFunctions(*F1, *F2))
-      if (opt_error_fatal)
-        goto end;
+    if (!opt_corpus.empty())
+      smt::solver_log_queries(&queries);
+    auto num_unsound = verifier.num_unsound;
+    bool ok = verifier.compareFunctions(*F1, *F2);
+    smt::solver_log_queries(nullptr);
+    stats.update(verifier, corpus);
+
+    if (verifier.num_unsound > num_unsound) {
+      auto Path = "unsound_" + to_string(rep) + ".ll";
+      *out << "saving the miscompiled function as '" << Path << "'\n";
+      error_code EC;
+      raw_fd_ostream File(Path, EC);
+      if (EC)
+        report_fatal_error("Couldn't open output file, exiting");
+      M.print(File, nullptr);
+    }
+
+    if (!ok && opt_error_fatal) {
+      stop = true;
+      if (opt_smt_stats)
+        smt::solver_print_stats(*out);
+      return FuzzStatus::Stopped;
+    }
+
+    if (!opt_corpus.empty()) {
+      set<string> features;
+      for (auto &P : changed_passes)
+        features.emplace("pass:" + P);
+      for (auto &Q : queries)
+        features.emplace("query:" + Q);
+      corpus.add(M, features, seed);
+    }
+
+    if (Mutated)
+      continue;
 
     F1->eraseFromParent();
     vector<Function *> Funcs;
@@ -1020,22 +1412,154 @@ reduced using llvm-reduce.
       F->eraseFromParent();
   }
 
-  *out << "Summary:\n"
-          "  "
-       << verifier.num_correct
-       << " correct transformations\n"
-          "  "
-       << verifier.num_unsound
-       << " incorrect transformations\n"
-          "  "
-       << verifier.num_failed
-       << " failed-to-prove transformations\n"
-          "  "
-       << verifier.num_errors << " Alive2 errors\n";
-
-end:
   if (opt_smt_stats)
     smt::solver_print_stats(*out);
+  return FuzzStatus::Done;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::InitLLVM X(argc, argv);
+  EnableDebugBuffering = true;
+
+  string Usage =
+      R"EOF(Alive2 simple generative fuzzer:
+version )EOF";
+  Usage += alive_version;
+  Usage += R"EOF(
+see quick-fuzz --version for LLVM version info,
+
+This program stress-tests LLVM and Alive2 by performing randomized
+generation of LLVM functions, optimizing them, and then checking
+refinement.
+
+It currently contains two simple generators: "value," which generates
+a single basic block containing integer operations, and "bb," which
+exercises loop and control flow optimizations.
+
+The recommended workflow is to run quick-fuzz until it finds an issue,
+and then re-run with the same seed and also the --save-ir command line
+option, in order to get a standalone test case that can then be
+reduced using llvm-reduce.
+)EOF";
+
+  cl::HideUnrelatedOptions(alive_cmdargs);
+  cl::ParseCommandLineOptions(argc, argv, Usage);
+
+  unique_ptr<Cache> cache;
+  unique_ptr<Module> MDummy;
+#define ARGS_MODULE_VAR MDummy
+#include "llvm_util/cmd_args_def.h"
+
+  function<unique_ptr<Fuzzer>(Module &, long)> makeFuzzer;
+  if (opt_fuzzer == "value") {
+    makeFuzzer = [](Module &M, long seed) {
+      return make_unique<ValueFuzzer>(M, seed);
+    };
+  } else if (opt_fuzzer == "bb") {
+    makeFuzzer = [](Module &M, long seed) {
+      return make_unique<BBFuzzer>(M, seed);
+    };
+  } else {
+    *out << "Available fuzzers are \"value\" and \"bb\".\n\n";
+    exit(-1);
+  }
+
+  unsigned long main_seed =
+      (opt_rand_seed == 0) ? random_device{}() : opt_rand_seed;
+  long num_reps = opt_num_reps;
+  unsigned num_workers = clamp<long>(opt_jobs, 1, max(num_reps, 1l));
+
+  /*
+   * with -j, each worker process runs a contiguous range of repetitions
+   * with its own LLVM context and SMT solver. Workers publish their
+   * counts in shared memory after every repetition, and their output
+   * is forwarded to the parent in worker order.
+   */
+  auto *stats = allocShared<FuzzStats>(num_workers);
+  auto *stop = allocShared<atomic<bool>>(1);
+
+  FuzzStatus status = FuzzStatus::Done;
+  if (num_workers == 1) {
+    status = fuzz(makeFuzzer, 0, opt_num_reps, main_seed, stats[0], *stop);
+  } else {
+    ostream *out_orig = out;
+    stringstream parent_ss;
+    unrestricted parallelMgr(num_workers, parent_ss, *out);
+    ENSURE(parallelMgr.init());
+    out = &parent_ss;
+    set_outs(*out);
+
+    vector<int> workers;
+    for (unsigned i = 0; i < num_workers; ++i) {
+      auto [pid, osp, index] = parallelMgr.limitedFork();
+      if (pid == -1) {
+        perror("fork() failed");
+        exit(-1);
+      }
+
+      if (pid != 0) {
+        *out << "include(" << index << ")\n";
+        workers.push_back(index);
+        continue;
+      }
+
+      out = osp;
+      set_outs(*out);
+      int first = opt_num_reps * i / num_workers;
+      int last = opt_num_reps * (i + 1) / num_workers;
+      auto st = fuzz(makeFuzzer, first, last, main_seed, stats[i], *stop,
+                     &parallelMgr);
+      parallelMgr.finishChild(/*is_timeout=*/false);
+      _exit(st == FuzzStatus::BadPasses ? 1 : 0);
+    }
+
+    parallelMgr.finishParent();
+    out = out_orig;
+    set_outs(*out);
+
+    for (unsigned i = 0; i < num_workers; ++i) {
+      auto wstatus = parallelMgr.getExitStatus(workers[i]);
+      if (!wstatus || !WIFEXITED(*wstatus)) {
+        *out << "Worker " << i << " crashed\n";
+        ++stats[i].num_errors;
+      } else if (WEXITSTATUS(*wstatus) != 0) {
+        status = FuzzStatus::BadPasses;
+      }
+    }
+    if (*stop)
+      status = max(status, FuzzStatus::Stopped);
+  }
+
+  FuzzStats total;
+  for (unsigned i = 0; i < num_workers; ++i) {
+    total += stats[i];
+  }
+  munmap(stats, sizeof(FuzzStats) * num_workers);
+  munmap(stop, sizeof(atomic<bool>));
+
+  if (status == FuzzStatus::BadPasses)
+    return -1;
+
+  if (status == FuzzStatus::Done) {
+    *out << "Summary:\n"
+            "  "
+         << total.num_correct
+         << " correct transformations\n"
+            "  "
+         << total.num_unsound
+         << " incorrect transformations\n"
+            "  "
+         << total.num_failed
+         << " failed-to-prove transformations\n"
+            "  "
+         << total.num_errors << " Alive2 errors\n";
+    if (!opt_corpus.empty())
+      *out << "  " << total.corpus_added
+           << " functions added to the corpus\n";
+  }
 
-  return verifier.num_errors > 0;
+  return total.num_errors > 0;
 }
@@ -254,12 +254,15 @@ static bool error(Errors &errs, State &src_state, State &tgt_state,
     s << " for " << *var;
   s << "\n\nExample:\n";
 
+  vector<pair<string, string>> example;
   for (auto &var: src_state.getFn().getInputs()) {
-    s << var << " = ";
-    print_model_val(s, src_state, m, &var, var.getType(),
+    stringstream val;
+    print_model_val(val, src_state, m, &var, var.getType(),
                     src_state.at(var)->val);
-    s << '\n';
+    s << var << " = " << val.str() << '\n';
+    example.emplace_back(var.getName(), std::move(val).str());
   }
+  errs.setExample(std::move(example));
 
   set<string> seen_vars;
   for (auto st : { &src_state, &tgt_state }) {
@@ -1492,33 +1495,51 @@ Errors TransformVerify::verify() const {
 }
 
 
-TypingAssignments::TypingAssignments(const expr &e) : s(true), sneg(true) {
+TypingAssignments::TypingAssignments(const expr &e, bool use_native) {
   if (e.isTrue()) {
     has_only_one_solution = true;
-  } else {
-    EnableSMTQueriesTMP tmp;
-    s.add(e);
-    sneg.add(!e);
-    r = s.check("typing");
+    return;
+  }
+
+  if (use_native) {
+    native = make_unique<ModelEnumerator>(e);
+    if (native->isSupported()) {
+      is_unsat = !native->next();
+      return;
+    }
+    native.reset();
   }
+
+  EnableSMTQueriesTMP tmp;
+  s = make_unique<Solver>(true);
+  sneg = make_unique<Solver>(true);
+  s->add(e);
+  sneg->add(!e);
+  r = s->check("typing");
 }
 
 TypingAssignments::operator bool() const {
-  return !is_unsat && (has_only_one_solution || r.isSat());
+  return !is_unsat && (has_only_one_solution || native || r.isSat());
 }
 
 void TypingAssignments::operator++(void) {
   if (has_only_one_solution) {
     is_unsat = true;
+  } else if (native) {
+    is_unsat = !native->next();
   } else {
     EnableSMTQueriesTMP tmp;
-    s.block(r.getModel(), &sneg);
-    r = s.check("typing");
+    s->block(r.getModel(), sneg.get());
+    r = s->check("typing");
     assert(r.isSat() || r.isUnsat());
   }
 }
 
-TypingAssignments TransformVerify::getTypings() const {
+const Model& TypingAssignments::getModel() const {
+  return native ? native->getModel() : r.getModel();
+}
+
+expr TransformVerify::getTypeConstraints() const {
   auto c = t.src.getTypeConstraints() && t.tgt.getTypeConstraints();
 
   if (t.precondition)
@@ -1533,16 +1554,58 @@ TypingAssignments TransformVerify::getTypings() const {
         c &= i.getType() == tgt_instrs.at(i.getName())->getType();
     }
   }
-  return { std::move(c) };
+  return c;
+}
+
+TypingAssignments TransformVerify::getTypings() const {
+  return { getTypeConstraints() };
+}
+
+Errors TransformVerify::checkTypings(unsigned &num) {
+  // the models may assign different sets of irrelevant variables, so
+  // compare the typed transforms instead
+  auto typed = [this](TypingAssignments &ty) {
+    vector<string> ret;
+    for (; ty; ++ty) {
+      fixupTypes(ty);
+      stringstream ss;
+      ss << t;
+      ret.emplace_back(std::move(ss).str());
+    }
+    ranges::sort(ret);
+    return ret;
+  };
+
+  auto c = getTypeConstraints();
+  TypingAssignments native(c), z3(c, false);
+  bool is_native = native.native != nullptr;
+  auto native_tys = typed(native);
+  auto z3_tys = typed(z3);
+  num = native_tys.size();
+
+  if (native_tys.size() != z3_tys.size())
+    return { "Number of typings differs from the SMT solver's: " +
+               to_string(native_tys.size()) + " vs " +
+               to_string(z3_tys.size()), false };
+
+  auto [n, z] = ranges::mismatch(native_tys, z3_tys);
+  if (n != native_tys.end())
+    return { "Typing not enumerated by the SMT solver:" + *n, false };
+
+  Errors errs;
+  if (!is_native && !c.isTrue())
+    errs.addWarning("The typings are not supported by the native enumerator");
+  return errs;
 }
 
 void TransformVerify::fixupTypes(const TypingAssignments &ty) {
   if (ty.has_only_one_solution)
     return;
+  auto &m = ty.getModel();
   if (t.precondition)
-    t.precondition->fixupTypes(ty.r.getModel());
-  t.src.fixupTypes(ty.r.getModel());
-  t.tgt.fixupTypes(ty.r.getModel());
+    t.precondition->fixupTypes(m);
+  t.src.fixupTypes(m);
+  t.tgt.fixupTypes(m);
 }
 
 static map<string_view, Instr*> can_remove_init(Function &fn) {
@@ -1957,6 +2020,9 @@ void Transform::preprocess() {
 
   src.unroll(config::src_unroll_cnt);
   tgt.unroll(config::tgt_unroll_cnt);
+
+  src.number();
+  tgt.number();
 }
 
 void Transform::print(ostream &os, const TransformPrintOpts &opt) const {
@@ -1979,4 +2045,54 @@ ostream& operator<<(ostream &os, const Transform &t) {
   return os;
 }
 
+
+static void add_costs(CostEstimate &c, const Function &f, unsigned unroll) {
+  auto &bbs = f.getBBs();
+  unordered_map<const BasicBlock*, unsigned> bb_idx;
+  for (unsigned i = 0, e = bbs.size(); i != e; ++i) {
+    bb_idx.emplace(bbs[i], i);
+  }
+
+  for (unsigned i = 0, e = bbs.size(); i != e; ++i) {
+    auto &bb = *bbs[i];
+    c.num_instrs += bb.size();
+
+    for (auto &inst : bb.instrs()) {
+      if (dynamic_cast<const MemInstr*>(&inst) &&
+          !dynamic_cast<const GEP*>(&inst))
+        ++c.num_mem_ops;
+    }
+
+    if (!unroll)
+      continue;
+
+    // approximate loops by back edges in the block order
+    for (auto &dst : bb.targets()) {
+      auto I = bb_idx.find(&dst);
+      if (I == bb_idx.end() || I->second > i)
+        continue;
+      unsigned body = 0;
+      for (unsigned j = I->second; j <= i; ++j) {
+        body += bbs[j]->size();
+      }
+      c.num_loop_instrs += body * unroll;
+    }
+  }
+}
+
+CostEstimate::CostEstimate(const Transform &t) {
+  add_costs(*this, t.src, config::src_unroll_cnt);
+  add_costs(*this, t.tgt, config::tgt_unroll_cnt);
+}
+
+double CostEstimate::cost() const {
+  return num_instrs + num_loop_instrs + num_mem_ops;
+}
+
+ostream& operator<<(ostream &os, const CostEstimate &c) {
+  return os << c.cost() << " (instrs: " << c.num_instrs
+            << ", mem: " << c.num_mem_ops
+            << ", loop: " << c.num_loop_instrs << ')';
+}
+
 }
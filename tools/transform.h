@@ -5,6 +5,7 @@
 
 #include "ir/function.h"
 #include "ir/state.h"
+#include "smt/enumerator.h"
 #include "smt/solver.h"
 #include "util/errors.h"
 #include <memory>
@@ -33,14 +34,36 @@ struct Transform {
 };
 
 
+/// A proxy for the cost of verifying a transformation, used to schedule
+/// parallel verification: the number of instructions, counting each copy of
+/// unrolled loop bodies, plus the number of memory operations. It is not
+/// calibrated against actual run times.
+struct CostEstimate {
+  unsigned num_instrs = 0;
+  unsigned num_mem_ops = 0;
+  // instructions in loop bodies, multiplied by the unroll factor
+  unsigned num_loop_instrs = 0;
+
+  CostEstimate(const Transform &t);
+  double cost() const;
+  friend std::ostream& operator<<(std::ostream &os, const CostEstimate &c);
+};
+
+
+// Typings are enumerated natively when possible; the SMT solver is only
+// used for constraints the native enumerator can't evaluate.
 class TypingAssignments {
-  smt::Solver s, sneg;
+  std::unique_ptr<smt::ModelEnumerator> native;
+  std::unique_ptr<smt::Solver> s, sneg;
   smt::Result r;
   bool has_only_one_solution = false;
   bool is_unsat = false;
 
+  const smt::Model& getModel() const;
+
 public:
-  TypingAssignments(const smt::expr &e);
+  // native: enumerate with smt::ModelEnumerator if it supports e
+  TypingAssignments(const smt::expr &e, bool native = true);
   bool operator!() const { return !(bool)*this; }
   operator bool() const;
   void operator++(void);
@@ -55,11 +78,16 @@ class TransformVerify {
   std::unordered_map<std::string, const IR::Instr*> tgt_instrs;
   bool check_each_var;
 
+  smt::expr getTypeConstraints() const;
+
 public:
   TransformVerify(Transform &t, bool check_each_var);
   std::pair<std::unique_ptr<IR::State>,std::unique_ptr<IR::State>> exec() const;
   util::Errors verify() const;
   TypingAssignments getTypings() const;
+  // Checks that the typings enumerated natively are the same as those
+  // enumerated with the SMT solver; num is set to the number of typings.
+  util::Errors checkTypings(unsigned &num);
   void fixupTypes(const TypingAssignments &ty);
 };
 
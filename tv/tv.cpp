@@ -8,6 +8,7 @@
 #include "smt/smt.h"
 #include "smt/solver.h"
 #include "tools/transform.h"
+#include "util/file.h"
 #include "util/parallel.h"
 #include "util/stopwatch.h"
 #include "util/version.h"
@@ -19,8 +20,12 @@
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/TargetParser/Triple.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <fcntl.h>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <random>
 #include <signal.h>
@@ -54,20 +59,89 @@ llvm::cl::opt<int> max_subprocesses("max-subprocesses",
                  "time (default=128)"),
   llvm::cl::init(128), llvm::cl::cat(alive_cmdargs));
 
+llvm::cl::opt<unsigned> max_buffered_output("tv-parallel-max-buffer",
+  llvm::cl::desc("Maximum size, in MB, of children's output that is kept in "
+                 "memory while waiting for earlier output; the rest is "
+                 "spilled to temporary files (default=64)"),
+  llvm::cl::init(64), llvm::cl::value_desc("MB"),
+  llvm::cl::cat(alive_cmdargs));
+
 llvm::cl::opt<long> subprocess_timeout("tv-subprocess-timeout",
   llvm::cl::desc("Maximum time, in seconds, that a parallel TV call "
                  "will be allowed to execute (default=infinite)"),
   llvm::cl::init(-1), llvm::cl::cat(alive_cmdargs));
 
+llvm::cl::opt<bool> resource_stats("tv-resource-stats",
+  llvm::cl::desc("Report CPU time, memory, and SMT queries of each parallel "
+                 "TV call"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<string> schedule_opt("tv-schedule",
+  llvm::cl::desc("Order in which parallel TV calls are started. Accepted "
+                 "values: fifo (default), shortest-first, longest-first"),
+  llvm::cl::init("fifo"), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<unsigned> max_queued("tv-max-queued",
+  llvm::cl::desc("Maximum number of TV calls waiting to be scheduled when "
+                 "not using fifo scheduling (default=1024)"),
+  llvm::cl::init(1024), llvm::cl::cat(alive_cmdargs));
+
 llvm::cl::opt<bool> batch_opts("tv-batch-opts",
   llvm::cl::desc("Batch optimizations (clang plugin only)"),
   llvm::cl::cat(alive_cmdargs));
 
+llvm::cl::opt<bool> adaptive_batch("tv-adaptive-batch",
+  llvm::cl::desc("Verify windows of consecutive passes at once, growing them "
+                 "while verification is quick, and bisect failing windows "
+                 "to find the culprit pass (not with -tv-parallel)"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<unsigned> max_batch_size("tv-adaptive-batch-max",
+  llvm::cl::desc("Maximum number of passes verified at once with "
+                 "-tv-adaptive-batch (default=64)"),
+  llvm::cl::init(64), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<bool> pass_profile("tv-pass-profile",
+  llvm::cl::desc("Print the cost of verifying each pass at the end"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<string> pass_profile_json("tv-pass-profile-json",
+  llvm::cl::desc("Write the cost of verifying each pass as JSON to this file"),
+  llvm::cl::value_desc("filename"), llvm::cl::cat(alive_cmdargs));
+
+
+// A function after a pass that changed it
+struct Snapshot {
+  Function fn;
+  string fn_tostr;
+  string pass;
+  unsigned n;
+};
 
 struct FnInfo {
   Function fn;
   string fn_tostr;
+  uint64_t fingerprint = 0;
   unsigned n = 0;
+  // -tv-adaptive-batch: fn is the start of the window, followed by these
+  vector<Snapshot> window;
+  unsigned window_size = 1;
+};
+
+// Cost of verifying the transformations of a pass
+struct PassProfile {
+  unsigned visited = 0;
+  unsigned skipped = 0; // syntactically equal or nop
+  unsigned correct = 0;
+  unsigned unsound = 0;
+  unsigned failed = 0;
+  double translation_time = 0;
+  double symexec_time = 0;
+  double smt_time = 0;
+
+  double totalTime() const {
+    return translation_time + symexec_time + smt_time;
+  }
 };
 
 optional<smt::smt_initializer> smt_init;
@@ -80,9 +154,18 @@ bool is_clangtv = false;
 bool is_clangtv_done = false;
 unique_ptr<Cache> cache;
 unique_ptr<parallel> parallelMgr;
+schedule schedule_policy = schedule::fifo;
 stringstream parent_ss;
-std::string SavedBitcode;
+// Module to write as bitcode if a transformation turns out to be unsound.
+// Serializing is expensive and almost never needed, so it is only done
+// then. This is the live module until a function or loop pass is about to
+// change it, and SavedModuleCopy after that.
+const llvm::Module *SavedModule = nullptr;
+shared_ptr<const llvm::Module> SavedModuleCopy;
 string pass_name;
+map<string, PassProfile> pass_profiles;
+// parallel children append the results of their checks to this file
+int profile_fd = -1;
 
 void sigalarm_handler(int) {
   parallelMgr->finishChild(/*is_timeout=*/true);
@@ -110,6 +193,133 @@ void showStats() {
     IR::Memory::printAliasStats(*out);
 }
 
+bool profiling() {
+  return pass_profile || !pass_profile_json.empty();
+}
+
+PassProfile* currentProfile() {
+  return profiling() ? &pass_profiles[pass_name] : nullptr;
+}
+
+enum class CheckResult { Correct, Unsound, Failed };
+
+void addCheck(PassProfile &p, double symexec_time, double smt_time,
+              CheckResult res) {
+  p.symexec_time += symexec_time;
+  p.smt_time += smt_time;
+  switch (res) {
+  case CheckResult::Correct: ++p.correct; break;
+  case CheckResult::Unsound: ++p.unsound; break;
+  case CheckResult::Failed:  ++p.failed; break;
+  }
+}
+
+void recordCheck(double symexec_time, double smt_time, CheckResult res) {
+  if (parallelMgr) {
+    // a single write with O_APPEND doesn't interleave with other children
+    stringstream ss;
+    ss << symexec_time << '\t' << smt_time << '\t' << (int)res << '\t'
+       << pass_name << '\n';
+    auto str = std::move(ss).str();
+    ENSURE(write(profile_fd, str.data(), str.size()) == (ssize_t)str.size());
+    return;
+  }
+  addCheck(pass_profiles[pass_name], symexec_time, smt_time, res);
+}
+
+void readChildrenProfiles() {
+  string data;
+  char buf[4096];
+  ssize_t n;
+  ENSURE(lseek(profile_fd, 0, SEEK_SET) == 0);
+  while ((n = read(profile_fd, buf, sizeof(buf))) > 0) {
+    data.append(buf, n);
+  }
+  close(profile_fd);
+  profile_fd = -1;
+
+  istringstream is(std::move(data));
+  double symexec_time, smt_time;
+  int res;
+  string pass;
+  while (is >> symexec_time >> smt_time >> res &&
+         is.ignore() && getline(is, pass)) {
+    addCheck(pass_profiles[pass], symexec_time, smt_time, (CheckResult)res);
+  }
+}
+
+string jsonEscape(const string &str) {
+  string ret;
+  for (char c : str) {
+    switch (c) {
+    case '"':  ret += "\\\""; break;
+    case '\\': ret += "\\\\"; break;
+    case '\n': ret += "\\n"; break;
+    case '\t': ret += "\\t"; break;
+    case '\r': ret += "\\r"; break;
+    default:
+      if ((unsigned char)c < 0x20) {
+        static const char hex[] = "0123456789abcdef";
+        ret += "\\u00";
+        ret += hex[c >> 4];
+        ret += hex[c & 0xf];
+      } else {
+        ret += c;
+      }
+    }
+  }
+  return ret;
+}
+
+void printPassProfiles() {
+  vector<pair<const string*, const PassProfile*>> sorted;
+  for (auto &[name, p] : pass_profiles) {
+    sorted.emplace_back(&name, &p);
+  }
+  sort(sorted.begin(), sorted.end(), [](auto &a, auto &b) {
+    return a.second->totalTime() > b.second->totalTime();
+  });
+
+  if (pass_profile) {
+    *out << "\n=== Verification cost per pass ===\n"
+         << "   total   llvm2alive  sym exec      SMT  visited  skipped"
+            "  correct  unsound   failed  pass\n" << fixed << setprecision(3);
+    for (auto &[name, p] : sorted) {
+      *out << setw(8) << p->totalTime() << setw(13) << p->translation_time
+           << setw(10) << p->symexec_time << setw(9) << p->smt_time
+           << setw(9) << p->visited << setw(9) << p->skipped
+           << setw(9) << p->correct << setw(9) << p->unsound
+           << setw(9) << p->failed << "  "
+           << (name->empty() ? "<unnamed>" : *name) << '\n';
+    }
+    *out << defaultfloat;
+  }
+
+  if (!pass_profile_json.empty()) {
+    ofstream json(pass_profile_json);
+    if (!json.is_open()) {
+      cerr << "Alive2: Couldn't open pass profile file" << endl;
+      exit(1);
+    }
+    json << "[\n";
+    bool first = true;
+    for (auto &[name, p] : sorted) {
+      json << (first ? "" : ",\n")
+           << "  {\"pass\": \"" << jsonEscape(*name) << "\", "
+           << "\"visited\": " << p->visited << ", "
+           << "\"skipped\": " << p->skipped << ", "
+           << "\"llvm2alive_time\": " << p->translation_time << ", "
+           << "\"symexec_time\": " << p->symexec_time << ", "
+           << "\"smt_time\": " << p->smt_time << ", "
+           << "\"correct\": " << p->correct << ", "
+           << "\"unsound\": " << p->unsound << ", "
+           << "\"failed\": " << p->failed << '}';
+      first = false;
+    }
+    json << "\n]\n";
+  }
+}
+
 void writeBitcode(const fs::path &report_filename) {
   fs::path bc_filename;
   if (report_filename.empty()) {
@@ -125,15 +335,32 @@ void writeBitcode(const fs::path &report_filename) {
     cerr << "Alive2: Couldn't open bitcode file" << endl;
     exit(1);
   }
-  bc_file << SavedBitcode;
+  string bitcode;
+  llvm::raw_string_ostream OS(bitcode);
+  WriteBitcodeToFile(*SavedModule, OS);
+  OS.flush();
+  bc_file << bitcode;
   bc_file.close();
   *out << "Wrote bitcode to: " << bc_filename << '\n';
 }
 
-void saveBitcode(const llvm::Module *M) {
-  SavedBitcode.clear();
-  llvm::raw_string_ostream OS(SavedBitcode);
-  WriteBitcodeToFile(*M, OS);
+void saveModule(const llvm::Module *M) {
+  SavedModule = M;
+  SavedModuleCopy.reset();
+}
+
+// For when passes run before a failure is reported
+void saveModuleCopy(const llvm::Module *M) {
+  SavedModuleCopy = llvm::CloneModule(*M);
+  SavedModule = SavedModuleCopy.get();
+}
+
+// Returns a copy of the saved module that later passes don't change.
+// Jobs queued before the module changes share the same copy.
+shared_ptr<const llvm::Module> pinSavedModule() {
+  if (SavedModule && SavedModule != SavedModuleCopy.get())
+    saveModuleCopy(SavedModule);
+  return SavedModuleCopy;
 }
 
 void emitCommandLine(ostream *out) {
@@ -184,6 +411,10 @@ struct TVLegacyPass final : public llvm::ModulePass {
         *out << "Took " << sw.seconds() << "s\n";
       });
 
+    auto *profile = currentProfile();
+    if (profile)
+      ++profile->visited;
+
     llvm::TargetLibraryInfo *TLI = nullptr;
     if (TLI_override) {
       // When used as a clang plugin or from the new pass manager, this is run
@@ -204,57 +435,224 @@ struct TVLegacyPass final : public llvm::ModulePass {
       return false;
     }
 
-    if (!first && nop_transform)
+    if (!first && nop_transform) {
+      if (profile)
+        ++profile->skipped;
+      return false;
+    }
+
+    auto translate = [&](bool is_src, const vector<GlobalVariable*> &gvs,
+                         bool *valid_as_src) {
+      StopWatch sw;
+      auto fn = llvm2alive(F, *TLI, is_src, gvs, valid_as_src);
+      sw.stop();
+      if (profile)
+        profile->translation_time += sw.seconds();
+      return fn;
+    };
+
+    // Skip the translation altogether if the LLVM IR didn't change
+    uint64_t fingerprint = opt_always_verify ? 0 : llvm_util::fingerprint(F);
+    if (!first && !opt_always_verify &&
+        fingerprint == I->second.fingerprint) {
+      printDot(I->second.fn, I->second.n++);
+      if (profile && !unsupported_transform)
+        ++profile->skipped;
+      if (!unsupported_transform && !adaptive_batch) {
+        if (!config::quiet)
+          *out << "\n----------------------------------------\n"
+               << I->second.fn_tostr;
+        *out << "Transformation seems to be correct! (syntactically equal)\n\n";
+      }
       return false;
+    }
 
-    auto fn = llvm2alive(F, *TLI, first,
-                         first ? vector<GlobalVariable*>()
-                               : I->second.fn.getGlobalVars());
+    bool valid_as_src = true;
+    auto fn = translate(first,
+                        first ? vector<GlobalVariable*>()
+                              : I->second.fn.getGlobalVars(),
+                        &valid_as_src);
     if (!fn) {
+      verifyWindow(I->second);
       fns.erase(I);
       return false;
     }
 
     if (first || unsupported_transform) {
+      verifyWindow(I->second);
       I->second.fn = std::move(*fn);
-      if (!opt_always_verify)
+      I->second.fingerprint = fingerprint;
+      if (!opt_always_verify || adaptive_batch)
         // Prepare syntactic check
         I->second.fn_tostr = toString(I->second.fn);
       printDot(I->second.fn, I->second.n++);
       return false;
     }
 
+    if (adaptive_batch) {
+      auto &info = I->second;
+      auto tgt_tostr = toString(*fn);
+      info.fingerprint = fingerprint;
+      printDot(*fn, info.n);
+      auto &prev = info.window.empty() ? info.fn_tostr
+                                       : info.window.back().fn_tostr;
+      if (!opt_always_verify && tgt_tostr == prev) {
+        ++info.n;
+        return false;
+      }
+
+      info.window.push_back({ std::move(*fn), std::move(tgt_tostr), pass_name,
+                              info.n++ });
+      // a target that can't be the next source must end the window
+      if (valid_as_src && info.window.size() < info.window_size)
+        return false;
+
+      verifyWindow(info);
+      if (!valid_as_src) {
+        fn = translate(true, {}, nullptr);
+        if (!fn) {
+          fns.erase(I);
+          return false;
+        }
+        info.fn = std::move(*fn);
+        info.fn_tostr = toString(info.fn);
+      }
+      return false;
+    }
+
     Transform t;
     t.src = std::move(I->second.fn);
     t.tgt = std::move(*fn);
 
-    verify(t, I->second.n++, I->second.fn_tostr);
+    // The target becomes the source of the next pass. Verification may
+    // change it, so take a copy now instead of translating F again later.
+    optional<Function> next_src;
+    if (valid_as_src)
+      next_src = t.tgt.dup();
 
-    fn = llvm2alive(F, *TLI, true);
-    if (!fn) {
-      fns.erase(I);
-      return false;
+    auto tgt_tostr = toString(t.tgt);
+    verify(t, I->second.n++, I->second.fn_tostr, tgt_tostr);
+
+    if (!next_src) {
+      next_src = translate(true, {}, nullptr);
+      if (!next_src) {
+        fns.erase(I);
+        return false;
+      }
+      if (!opt_always_verify)
+        tgt_tostr = toString(*next_src);
     }
-    I->second.fn = std::move(*fn);
+    I->second.fn = std::move(*next_src);
+    I->second.fingerprint = fingerprint;
     if (!opt_always_verify)
-      I->second.fn_tostr = toString(I->second.fn);
+      I->second.fn_tostr = std::move(tgt_tostr);
     return false;
   }
 
-  static void verify(Transform &t, int n, const string &src_tostr) {
+  // Verifies the pending window of passes of a function with a single
+  // query. If that fails, bisect the window using the stored snapshots
+  // to find the pass to blame.
+  static void verifyWindow(FnInfo &info) {
+    // take the window first as a failure may call finalize()
+    vector<Snapshot> w;
+    swap(w, info.window);
+    if (w.empty())
+      return;
+
+    StopWatch sw;
+    bool ok;
+    if (w.size() == 1) {
+      ok = verifyPass(info.fn, info.fn_tostr, w[0]);
+    } else if ((ok = probe(info.fn, w.back().fn))) {
+      if (!config::quiet)
+        *out << "\n----------------------------------------\n"
+             << "Passes " << w.front().pass << " .. " << w.back().pass
+             << '\n';
+      *out << "Transformation seems to be correct! (batch of " << w.size()
+           << " passes)\n\n";
+    } else {
+      *out << "\nBatch of " << w.size()
+           << " passes doesn't verify; bisecting\n";
+      // invariant: lo -> hi doesn't verify; -1 is the start of the window
+      auto snapshot = [&](int i) -> const Function& {
+        return i < 0 ? info.fn : w[i].fn;
+      };
+      int lo = -1, hi = w.size() - 1;
+      while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (probe(snapshot(lo), snapshot(mid)))
+          lo = mid;
+        else
+          hi = mid;
+      }
+      verifyPass(snapshot(lo), lo < 0 ? info.fn_tostr : w[lo].fn_tostr, w[hi]);
+
+      // the passes after the culprit weren't verified yet; they start from
+      // its output
+      if (hi + 1 < (int)w.size()) {
+        info.fn = std::move(w[hi].fn);
+        info.fn_tostr = std::move(w[hi].fn_tostr);
+        info.window.assign(make_move_iterator(w.begin() + hi + 1),
+                           make_move_iterator(w.end()));
+        info.window_size = 1;
+        verifyWindow(info);
+        return;
+      }
+    }
+    sw.stop();
+
+    // grow the window while queries take less than 10% of the timeout
+    if (!ok)
+      info.window_size = 1;
+    else if (sw.seconds() * 1000 * 10 <= opt_smt_to)
+      info.window_size = min(info.window_size * 2,
+                             max(1u, (unsigned)max_batch_size));
+    else
+      info.window_size = max(1u, info.window_size / 2);
+
+    info.fn = std::move(w.back().fn);
+    info.fn_tostr = std::move(w.back().fn_tostr);
+  }
+
+  static bool verifyPass(const Function &src, const string &src_tostr,
+                         const Snapshot &tgt) {
+    Transform t;
+    t.src = src.dup();
+    t.tgt = tgt.fn.dup();
+    auto saved_pass_name = exchange(pass_name, tgt.pass);
+    bool ok = verify(t, tgt.n, src_tostr, tgt.fn_tostr);
+    pass_name = std::move(saved_pass_name);
+    return ok;
+  }
+
+  // Checks refinement without printing anything
+  static bool probe(const Function &src, const Function &tgt) {
+    Transform t;
+    t.src = src.dup();
+    t.tgt = tgt.dup();
+    smt_init->reset();
+    t.preprocess();
+    TransformVerify verifier(t, false);
+    return verifier.getTypings() && !verifier.verify();
+  }
+
+  // Returns false if the transformation is known not to verify
+  static bool verify(Transform &t, int n, const string &src_tostr,
+                     const string &tgt_tostr) {
     printDot(t.tgt, n);
 
-    auto tgt_tostr = toString(t.tgt);
     if (!opt_always_verify) {
       // Compare Alive2 IR and skip if syntactically equal
       if (src_tostr == tgt_tostr) {
+        if (auto *profile = currentProfile())
+          ++profile->skipped;
         if (!config::quiet) {
           TransformPrintOpts print_opts;
           print_opts.skip_tgt = true;
           t.print(*out, print_opts);
         }
         *out << "Transformation seems to be correct! (syntactically equal)\n\n";
-        return;
+        return true;
       }
     }
 
@@ -262,8 +660,30 @@ struct TVLegacyPass final : public llvm::ModulePass {
     // to do this before forking. Anyway, this is fast.
     if (opt_assume_cache_hit ||
         (cache && cache->lookup(src_tostr + "===\n" + tgt_tostr))) {
+      if (auto *profile = currentProfile())
+        ++profile->skipped;
       *out << "Skipping repeated query\n\n";
-      return;
+      return true;
+    }
+
+    if (parallelMgr && schedule_policy != schedule::fifo) {
+      /*
+       * the job may be forked much later, so it has to carry its own
+       * copy of the state it reports
+       */
+      CostEstimate cost(t);
+      parallelMgr->enqueue(cost.cost(),
+        [tp = make_shared<Transform>(std::move(t)), pass = pass_name,
+         module = pinSavedModule(), cost](ostream &os) {
+          pass_name = pass;
+          SavedModuleCopy = module;
+          SavedModule = module.get();
+          startChild(&os);
+          if (resource_stats)
+            *out << "Estimated cost: " << cost << '\n';
+          check(*tp);
+        });
+      return true;
     }
 
     if (parallelMgr) {
@@ -280,35 +700,48 @@ struct TVLegacyPass final : public llvm::ModulePass {
          * the output that we'll patch up later
          */
         *out << "include(" << index << ")\n";
-        /*
-         * Tell the caller that tgt should be regenerated via llvm2alive.
-         * TODO: this llvm2alive() call isn't needed for correctness,
-         * but only to make parallel output match sequential
-         * output. we can remove it later if we want.
-         */
-        return;
+        return true;
       }
+      startChild(osp);
+    }
 
-      if (subprocess_timeout != -1) {
-        ENSURE(signal(SIGALRM, sigalarm_handler) == nullptr);
-        alarm(subprocess_timeout);
-      }
+    return check(t);
+  }
 
-      /*
-       * child now writes to a stringstream provided by the parallel
-       * manager, its output will get pushed to the parent via a pipe
-       * later on
-       */
-      out = osp;
-      set_outs(*out);
+  static void startChild(ostream *osp) {
+    if (subprocess_timeout != -1) {
+      ENSURE(signal(SIGALRM, sigalarm_handler) == nullptr);
+      alarm(subprocess_timeout);
     }
 
+    /*
+     * child now writes to a stringstream provided by the parallel
+     * manager, its output will get pushed to the parent via a pipe
+     * later on
+     */
+    out = osp;
+    set_outs(*out);
+  }
+
+  static bool check(Transform &t) {
     /*
      * from here, we must not return back to LLVM if parallelMgr
      * is non-null; instead we call parallelMgr->finishChild()
      */
 
+    auto result = CheckResult::Failed;
+    StopWatch sw;
+    double smt_time = smt::solver_total_time();
+    auto record = [&]() {
+      if (profiling()) {
+        sw.stop();
+        smt_time = smt::solver_total_time() - smt_time;
+        recordCheck(sw.seconds() - smt_time, smt_time, result);
+      }
+    };
+
     smt_init->reset();
+    unsigned num_queries = smt::solver_num_queries();
     t.preprocess();
     TransformVerify verifier(t, false);
     if (!config::quiet)
@@ -334,22 +767,31 @@ struct TVLegacyPass final : public llvm::ModulePass {
                 (errs.isUnsound() ? " (unsound)\n" : " (not unsound)\n")
             << errs;
         if (errs.isUnsound()) {
+          result = CheckResult::Unsound;
           has_failure = true;
           *out << "\nPass: " << pass_name << '\n';
           emitCommandLine(out);
-          if (!SavedBitcode.empty())
+          if (SavedModule)
             writeBitcode(report_filename);
           *out << "\n";
         }
-        if (opt_error_fatal && has_failure)
+        if (opt_error_fatal && has_failure) {
+          record();
           finalize();
+        }
       } else {
         *out << "Transformation seems to be correct!\n\n";
+        result = CheckResult::Correct;
       }
     }
 
   done:
+    record();
     if (parallelMgr) {
+      if (resource_stats)
+        *out << "Z3 peak memory: "
+             << smt::peak_memory_usage() / (1024 * 1024) << " MB, "
+             << (smt::solver_num_queries() - num_queries) << " SMT queries\n";
       showStats();
       signal(SIGALRM, SIG_IGN);
       llvm_util_init.reset();
@@ -357,6 +799,7 @@ struct TVLegacyPass final : public llvm::ModulePass {
       parallelMgr->finishChild(/*is_timeout=*/false);
       exit(0);
     }
+    return result == CheckResult::Correct;
   }
 
  bool doInitialization(llvm::Module &module) override {
@@ -387,8 +830,41 @@ struct TVLegacyPass final : public llvm::ModulePass {
       exit(1);
     }
 
+    if (adaptive_batch && batch_opts) {
+      *out << "Alive2: -tv-adaptive-batch cannot be used with -tv-batch-opts"
+           << endl;
+      exit(1);
+    }
+
+    // windows are probed and bisected in this process, which would leave
+    // the children idle
+    if (adaptive_batch && !parallel_tv.empty()) {
+      *out << "Alive2: -tv-adaptive-batch cannot be used with -tv-parallel"
+           << endl;
+      exit(1);
+    }
+
+    if (schedule_opt == "shortest-first") {
+      schedule_policy = schedule::shortest_first;
+    } else if (schedule_opt == "longest-first") {
+      schedule_policy = schedule::longest_first;
+    } else if (schedule_opt != "fifo") {
+      *out << "Alive2: Unknown scheduling policy: " << schedule_opt << endl;
+      exit(1);
+    }
+
     if (parallelMgr) {
       if (parallelMgr->init()) {
+        parallelMgr->setMaxBufferedOutput(
+          (size_t)max_buffered_output * 1024 * 1024);
+        parallelMgr->setReportResourceUsage(resource_stats);
+        if (schedule_policy != schedule::fifo)
+          parallelMgr->setSchedule(schedule_policy, max_queued);
+        if (profiling()) {
+          profile_fd = open_anonymous_tmpfile();
+          ENSURE(profile_fd != -1);
+          ENSURE(fcntl(profile_fd, F_SETFL, O_APPEND) == 0);
+        }
         out = &parent_ss;
         set_outs(*out);
       } else {
@@ -410,13 +886,23 @@ struct TVLegacyPass final : public llvm::ModulePass {
   }
 
   static void finalize() {
-    SavedBitcode.resize(0);
+    for (auto &[name, info] : fns) {
+      verifyWindow(info);
+    }
+    saveModule(nullptr);
     if (parallelMgr) {
       parallelMgr->finishParent();
       out = out_file.is_open() ? &out_file : &cout;
       set_outs(*out);
     }
 
+    if (profile_fd != -1)
+      readChildrenProfiles();
+    if (profiling()) {
+      printPassProfiles();
+      pass_profiles.clear();
+    }
+
     // If it is run in parallel, stats are shown by children
     if (!showed_stats && !parallelMgr) {
       showed_stats = true;
@@ -735,8 +1221,9 @@ llvmGetPassPluginInfo() {
           else if (is_first)
             TVPass::batched_pass_begin_name = "beginning";
 
+          // the passes of the batch run before it's verified
           if ((is_first || do_start) && opt_save_ir)
-            saveBitcode(unwrapModule(IR));
+            saveModuleCopy(unwrapModule(IR));
 
           if (is_first || do_start || do_finish)
             runTVPass(*const_cast<llvm::Module *>(unwrapModule(IR)));
@@ -751,6 +1238,12 @@ llvmGetPassPluginInfo() {
         auto fn = [](llvm::StringRef P, llvm::Any IR) {
           pass_name = P.str();
           if (is_clangtv && !is_clangtv_done) {
+            // function and loop passes change the saved module in place;
+            // copy it before the first one does
+            if (any_cast<const llvm::Function *>(&IR) ||
+                any_cast<const llvm::Loop *>(&IR))
+              pinSavedModule();
+
             if (auto **F = any_cast<const llvm::Function *>(&IR)) {
               runTVPass(*const_cast<llvm::Function*>(*F));
             } else if (auto **L = any_cast<const llvm::Loop *>(&IR)) {
@@ -758,7 +1251,7 @@ llvmGetPassPluginInfo() {
                                                          ->getParent()));
             } else {
               auto *M = unwrapModule(IR);
-              saveBitcode(M);
+              saveModule(M);
               runTVPass(*const_cast<llvm::Module*>(M));
             }
           }
@@ -0,0 +1,156 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/bitset.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+// Invariant: the bits past num_bits in the last word are zero.
+
+static uint64_t low_mask(size_t bits) {
+  return bits % 64 ? (uint64_t(1) << (bits % 64)) - 1 : ~uint64_t(0);
+}
+
+namespace util {
+
+BitSet::BitSet(size_t bits) : num_bits(bits) {
+  if (isInline())
+    memset(buf, 0, sizeof(buf));
+  else
+    heap = new uint64_t[numWords()]();
+}
+
+BitSet::BitSet(const BitSet &other) : num_bits(other.num_bits) {
+  if (isInline()) {
+    memcpy(buf, other.buf, sizeof(buf));
+  } else {
+    heap = new uint64_t[numWords()];
+    memcpy(heap, other.heap, numWords() * sizeof(uint64_t));
+  }
+}
+
+BitSet::BitSet(BitSet &&other) noexcept : num_bits(other.num_bits) {
+  memcpy(buf, other.buf, sizeof(buf));
+  other.num_bits = 0;
+}
+
+BitSet::~BitSet() {
+  if (!isInline())
+    delete[] heap;
+}
+
+BitSet& BitSet::operator=(const BitSet &other) {
+  if (this != &other) {
+    this->~BitSet();
+    new (this) BitSet(other);
+  }
+  return *this;
+}
+
+BitSet& BitSet::operator=(BitSet &&other) noexcept {
+  if (this != &other) {
+    this->~BitSet();
+    new (this) BitSet(std::move(other));
+  }
+  return *this;
+}
+
+void BitSet::resize(size_t bits) {
+  if (numWords(bits) == numWords()) {
+    if (bits < num_bits)
+      words()[numWords() - 1] &= low_mask(bits);
+    num_bits = bits;
+    return;
+  }
+
+  BitSet tmp(bits);
+  auto *w = tmp.words();
+  memcpy(w, words(), min(tmp.numWords(), numWords()) * sizeof(uint64_t));
+  if (bits < num_bits && bits % 64)
+    w[tmp.numWords() - 1] &= low_mask(bits);
+  *this = std::move(tmp);
+}
+
+void BitSet::setUpTo(size_t bits) {
+  auto *w = words();
+  size_t full = bits / 64;
+  for (size_t i = 0; i < full; ++i) {
+    w[i] = ~uint64_t(0);
+  }
+  if (bits % 64)
+    w[full] |= low_mask(bits);
+}
+
+size_t BitSet::count() const {
+  auto *w = words();
+  size_t n = 0;
+  for (size_t i = 0, e = numWords(); i != e; ++i) {
+    n += popcount(w[i]);
+  }
+  return n;
+}
+
+size_t BitSet::findFirstUnset() const {
+  auto *w = words();
+  for (size_t i = 0, e = numWords(); i != e; ++i) {
+    if (w[i] != ~uint64_t(0))
+      return min(num_bits, i * 64 + countr_one(w[i]));
+  }
+  return num_bits;
+}
+
+void BitSet::intersectWith(const BitSet &other) {
+  size_t bits = min(num_bits, other.num_bits);
+  if (bits == 0)
+    return;
+
+  auto *a = words();
+  auto *b = other.words();
+  size_t last = numWords(bits) - 1;
+  for (size_t i = 0; i < last; ++i) {
+    a[i] &= b[i];
+  }
+  a[last] &= b[last] | ~low_mask(bits);
+}
+
+void BitSet::unionWith(const BitSet &other) {
+  size_t bits = min(num_bits, other.num_bits);
+  if (bits == 0)
+    return;
+
+  auto *a = words();
+  auto *b = other.words();
+  size_t last = numWords(bits) - 1;
+  for (size_t i = 0; i < last; ++i) {
+    a[i] |= b[i];
+  }
+  a[last] |= b[last] & low_mask(bits);
+}
+
+strong_ordering BitSet::operator<=>(const BitSet &rhs) const {
+  size_t bits = min(num_bits, rhs.num_bits);
+  auto *a = words();
+  auto *b = rhs.words();
+  for (size_t i = 0, e = numWords(bits); i != e; ++i) {
+    uint64_t diff = a[i] ^ b[i];
+    if (i == e - 1)
+      diff &= low_mask(bits);
+    if (diff) {
+      // the first differing bit decides, as false < true
+      return (a[i] >> countr_zero(diff)) & 1 ? strong_ordering::greater
+                                             : strong_ordering::less;
+    }
+  }
+  return num_bits <=> rhs.num_bits;
+}
+
+bool BitSet::operator==(const BitSet &rhs) const {
+  return num_bits == rhs.num_bits &&
+         memcmp(words(), rhs.words(), numWords() * sizeof(uint64_t)) == 0;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+/// A dynamically-sized bitset packed in 64-bit words. Sets of up to
+/// 64 * inline_words bits don't allocate.
+class BitSet final {
+  static constexpr unsigned inline_words = 2;
+
+  size_t num_bits = 0;
+  union {
+    uint64_t buf[inline_words];
+    uint64_t *heap;
+  };
+
+  static size_t numWords(size_t bits) { return (bits + 63) / 64; }
+  size_t numWords() const { return numWords(num_bits); }
+  bool isInline() const { return numWords() <= inline_words; }
+  uint64_t* words() { return isInline() ? buf : heap; }
+  const uint64_t* words() const { return isInline() ? buf : heap; }
+
+public:
+  BitSet(size_t bits = 0);
+  BitSet(const BitSet &other);
+  BitSet(BitSet &&other) noexcept;
+  ~BitSet();
+
+  BitSet& operator=(const BitSet &other);
+  BitSet& operator=(BitSet &&other) noexcept;
+
+  size_t size() const { return num_bits; }
+  void resize(size_t bits); // new bits are unset
+  void clear() { *this = BitSet(); }
+
+  bool test(size_t i) const { return (words()[i / 64] >> (i % 64)) & 1; }
+  void set(size_t i) { words()[i / 64] |= uint64_t(1) << (i % 64); }
+  void reset(size_t i) { words()[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+
+  void setUpTo(size_t bits); // [0, bits)
+  size_t count() const;
+  size_t findFirstUnset() const; // size() if none
+
+  // Only the bits in both sets are considered; the remaining ones of this
+  // set are left unchanged.
+  void intersectWith(const BitSet &other);
+  void unionWith(const BitSet &other);
+
+  // Lexicographic, like std::vector<bool>
+  std::strong_ordering operator<=>(const BitSet &rhs) const;
+  bool operator==(const BitSet &rhs) const;
+};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/spaceship.h"
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/// A vector whose elements are shared between copies until written.
+/// Copying it only copies pointers; mut() clones an element the first time
+/// it's written after a copy. Reads must go through the const operator[].
+template <typename T>
+class cow_vector {
+  std::vector<std::shared_ptr<const T>> elems;
+
+public:
+  size_t size() const { return elems.size(); }
+  bool empty() const { return elems.empty(); }
+  void clear() { elems.clear(); }
+
+  const T& operator[](size_t i) const { return *elems[i]; }
+
+  T& mut(size_t i) {
+    auto &p = elems[i];
+    if (p.use_count() != 1)
+      p = std::make_shared<const T>(*p);
+    return const_cast<T&>(*p);
+  }
+
+  // The same copy of val is shared by all the new elements
+  void resize(size_t n, T val = T()) {
+    if (n <= elems.size()) {
+      elems.resize(n);
+      return;
+    }
+    elems.resize(n, std::make_shared<const T>(std::move(val)));
+  }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    elems.emplace_back(std::make_shared<const T>(std::forward<Args>(args)...));
+  }
+
+  // true if element i is shared with rhs, and thus equal
+  bool same(const cow_vector &rhs, size_t i) const {
+    return elems[i] == rhs.elems[i];
+  }
+
+  std::weak_ordering operator<=>(const cow_vector &rhs) const {
+    for (size_t i = 0, e = std::min(size(), rhs.size()); i != e; ++i) {
+      if (same(rhs, i))
+        continue;
+      if (auto cmp = (*this)[i] <=> rhs[i]; std::is_neq(cmp))
+        return cmp;
+    }
+    return size() <=> rhs.size();
+  }
+
+  bool operator==(const cow_vector &rhs) const {
+    return std::is_eq(*this <=> rhs);
+  }
+};
+
+}
@@ -37,6 +37,13 @@ void Errors::addWarning(const char *str) {
   warnings.emplace(str);
 }
 
+void Errors::setExample(vector<pair<string, string>> &&values) {
+  if (has_example)
+    return;
+  example = std::move(values);
+  has_example = true;
+}
+
 bool Errors::isUnsound() const {
   for (auto &[msg, unsound] : errs) {
     if (unsound)
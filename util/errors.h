@@ -7,6 +7,7 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace util {
 
@@ -23,6 +24,9 @@ public:
 class Errors {
   std::set<std::pair<std::string, bool>> errs;
   std::set<std::string> warnings;
+  // input name -> value, in the first counterexample found
+  std::vector<std::pair<std::string, std::string>> example;
+  bool has_example = false;
 
 public:
   Errors() = default;
@@ -34,10 +38,13 @@ public:
   void add(std::string &&str, bool is_unsound);
   void add(AliveException &&e);
   void addWarning(const char *str);
+  // Ignored if there's an example already
+  void setExample(std::vector<std::pair<std::string, std::string>> &&values);
 
   explicit operator bool() const { return !errs.empty(); }
   bool isUnsound() const;
   bool hasWarnings() const { return !warnings.empty(); }
+  auto& getExample() const { return example; }
 
   friend std::ostream& operator<<(std::ostream &os, const Errors &e);
   void printWarnings(std::ostream &os) const;
@@ -3,17 +3,82 @@
 
 #include "util/file.h"
 #include "util/random.h"
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 namespace fs = std::filesystem;
 
 namespace util {
 
-file_reader::file_reader(const char *filename, unsigned padding) {
+file_reader::file_reader(const char *filename, unsigned padding,
+                         bool use_mmap) {
+  if (use_mmap) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+      throw FileIOException();
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw FileIOException();
+    }
+
+    // pipes and FIFOs have no size to map, so read them instead
+    if (!S_ISREG(st.st_mode)) {
+      string contents;
+      char chunk[64 * 1024];
+      ssize_t n;
+      while ((n = read(fd, chunk, sizeof(chunk))) != 0) {
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n < 0) {
+          close(fd);
+          throw FileIOException();
+        }
+        contents.append(chunk, n);
+      }
+      close(fd);
+
+      sz = contents.size();
+      buf = make_unique<char[]>(sz + padding);
+      memcpy(buf.get(), contents.data(), sz);
+      memset(buf.get() + sz, 0, padding);
+      data = buf.get();
+      return;
+    }
+    sz = st.st_size;
+
+    // Reserve whole pages for the file plus the padding, and then map the
+    // file over the beginning of the reservation. The bytes past the end of
+    // the file are zero, whether in its last page or in the anonymous ones.
+    size_t page_sz = sysconf(_SC_PAGESIZE);
+    mapped_sz = (sz + padding + page_sz) / page_sz * page_sz;
+    void *p = mmap(nullptr, mapped_sz, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                   -1, 0);
+    if (p != MAP_FAILED && sz != 0 &&
+        mmap(p, sz, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+      munmap(p, mapped_sz);
+      p = MAP_FAILED;
+    }
+    close(fd);
+
+    if (p == MAP_FAILED) {
+      mapped_sz = 0;
+      throw FileIOException();
+    }
+    data = static_cast<char*>(p);
+    return;
+  }
+
   ifstream f(filename, ios::binary);
   if (!f)
     throw FileIOException();
@@ -24,6 +89,12 @@ file_reader::file_reader(const char *filename, unsigned padding) {
   buf = make_unique<char[]>(sz + padding);
   f.read(buf.get(), sz);
   memset(buf.get() + sz, 0, padding);
+  data = buf.get();
+}
+
+file_reader::~file_reader() {
+  if (mapped_sz)
+    munmap(data, mapped_sz);
 }
 
 
@@ -45,4 +116,15 @@ string get_random_filename(const string &dir, const char *extension,
   return path.string();
 }
 
+int open_anonymous_tmpfile() {
+  const char *tmpdir = getenv("TMPDIR");
+  string name = string(tmpdir ? tmpdir : "/tmp") + "/alive2-XXXXXX";
+  int fd = mkstemp(name.data());
+  if (fd != -1 && unlink(name.c_str()) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
 }
@@ -9,15 +9,25 @@
 
 namespace util {
 
+// Reads a whole file into memory, followed by padding zero bytes.
+// With use_mmap, the file is mapped instead of copied; the padding is made
+// of zero-filled anonymous pages right after the mapping. Files that can't
+// be mapped, like pipes, are read as usual.
 class file_reader {
   std::unique_ptr<char[]> buf;
+  char *data;
   size_t sz;
+  size_t mapped_sz = 0;
 
 public:
-  file_reader(const char *filename, unsigned padding = 0);
+  file_reader(const char *filename, unsigned padding = 0,
+              bool use_mmap = false);
+  file_reader(const file_reader&) = delete;
+  file_reader& operator=(const file_reader&) = delete;
+  ~file_reader();
 
   std::string_view operator*() const {
-    return { buf.get(), sz };
+    return { data, sz };
   }
 };
 
@@ -26,4 +36,8 @@ struct FileIOException {};
 std::string get_random_filename(const std::string &dir, const char *extension,
                                 const char *prefix = nullptr);
 
+// Creates a file in $TMPDIR (or /tmp) and unlinks it right away, so that it
+// goes away when closed. Returns its descriptor, or -1 on failure.
+int open_anonymous_tmpfile();
+
 }
@@ -3,15 +3,23 @@
 
 #include "util/parallel.h"
 #include "util/compiler.h"
+#include "util/file.h"
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
 #include <fcntl.h>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <string>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 using namespace std;
 
@@ -23,26 +31,76 @@ void parallel::ensureChild() {
   assert(parent_pid != -1 && getpid() != parent_pid);
 }
 
+#ifdef __linux__
+/*
+ * epoll user data: the index of the child, and whether the event is
+ * for the pidfd rather than the pipe
+ */
+static uint64_t epoll_key(int index, bool is_pidfd) {
+  return ((uint64_t)index << 1) | is_pidfd;
+}
+#endif
+
 bool parallel::init() {
   assert(parent_pid == -1);
+#ifdef __linux__
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd == -1)
+    return false;
+  // one pipe and one pidfd per child
+  events.resize(2 * max_active_children);
+#else
   for (int i = 0; i < max_active_children; ++i) {
     pfd_map.push_back(-1);
     auto &p = pfd.emplace_back();
     p.fd = -1;
     p.events = POLL_IN;
   }
+#endif
   parent_pid = getpid();
   return true;
 }
 
+parallel::~parallel() {
+#ifdef __linux__
+  if (epoll_fd != -1)
+    close(epoll_fd);
+#endif
+}
+
+void parallel::recordExit(pid_t pid, int status, const rusage &usage) {
+  auto I = pid_map.find(pid);
+  if (I == pid_map.end())
+    return;
+  childProcess &c = children[I->second];
+  c.wall_time = chrono::duration<double>(chrono::steady_clock::now() -
+                                         c.start).count();
+  c.status = status;
+  c.usage = usage;
+  c.reaped = true;
+  pid_map.erase(I);
+}
+
 void parallel::reapZombies() {
-  while (waitpid((pid_t)-1, nullptr, WNOHANG) > 0)
-    ;
+#ifdef __linux__
+  if (!reap_with_waitpid)
+    return;
+#endif
+  int status;
+  rusage usage;
+  pid_t pid;
+  while ((pid = wait4((pid_t)-1, &status, WNOHANG, &usage)) > 0)
+    recordExit(pid, status, usage);
 }
 
-std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
-  ensureParent();
+optional<int> parallel::getExitStatus(int index) const {
+  auto &c = children.at(index);
+  if (!c.reaped)
+    return {};
+  return c.status;
+}
 
+void parallel::waitForSlot() {
   /*
    * we don't want child processes getting blocked writing to their
    * output pipes, so drain them all without blocking the parent
@@ -58,20 +116,22 @@ std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
     readFromChildren(/*blocking=*/true);
     reapZombies();
   }
+}
 
+std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
+  ensureParent();
+  waitForSlot();
   getToken();
 
   int index = children.size();
   children.emplace_back();
-  childProcess &newKid = children.back();
+  return forkChild(index);
+}
 
-  /*
-   * amortize cost of copying part of the output stringstream to a new
-   * one by not doing this all that often
-   */
-  if (index % 100 == 0)
-    emitOutput();
+std::tuple<pid_t, std::ostream *, int> parallel::forkChild(int index) {
+  childProcess &newKid = children[index];
 
+  emitOutput();
   out_file.flush();
 
   // this is how the child will send results back to the parent
@@ -88,9 +148,21 @@ std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
      * child -- we inherited the read ends of potentially many pipes;
      * close all of the open ones (including the new one)
      */
-    for (auto &c : children)
-      if (!c.eof)
+    for (auto &c : children) {
+      if (!c.eof && c.pipe[0] != -1)
         ENSURE(close(c.pipe[0]) == 0);
+      if (c.spill_fd != -1)
+        ENSURE(close(c.spill_fd) == 0);
+      if (c.pidfd != -1)
+        ENSURE(close(c.pidfd) == 0);
+    }
+#ifdef __linux__
+    ENSURE(close(epoll_fd) == 0);
+    epoll_fd = -1;
+#endif
+    pending.clear();
+    queue.clear();
+    my_index = index;
     fd_to_parent = newKid.pipe[1];
   } else {
     /*
@@ -99,7 +171,26 @@ std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
     ENSURE(close(newKid.pipe[1]) == 0);
     ++active_children;
     newKid.pid = pid;
+    newKid.start = chrono::steady_clock::now();
+    pid_map.emplace(pid, index);
 
+#ifdef __linux__
+    ENSURE(fcntl(newKid.pipe[0], F_SETFL, O_NONBLOCK) == 0);
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.u64 = epoll_key(index, false);
+    ENSURE(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, newKid.pipe[0], &ev) == 0);
+
+    newKid.pidfd = syscall(SYS_pidfd_open, pid, 0);
+    if (newKid.pidfd != -1) {
+      ev.events = EPOLLIN;
+      ev.data.u64 = epoll_key(index, true);
+      ENSURE(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, newKid.pidfd, &ev) == 0);
+    } else {
+      // kernel without pidfd support (< 5.3)
+      reap_with_waitpid = true;
+    }
+#else
     bool found = false;
     for (int i = 0; i < max_active_children; ++i) {
       if (pfd[i].fd == -1) {
@@ -110,10 +201,66 @@ std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
       }
     }
     assert(found);
+#endif
   }
   return {pid, &newKid.output, index};
 }
 
+void parallel::setSchedule(schedule policy, size_t max_queued) {
+  this->policy = policy;
+  max_queued_jobs = max_queued;
+}
+
+void parallel::enqueue(double cost, function<void(ostream&)> &&job) {
+  ensureParent();
+  while (readFromChildren(/*blocking=*/false))
+    reapZombies();
+
+  int index = children.size();
+  children.emplace_back().estimated_cost = cost;
+  parent_ss << "include(" << index << ")\n";
+
+  double key = policy == schedule::fifo ? 0
+             : policy == schedule::shortest_first ? cost : -cost;
+  queue.push_back({ key, index, std::move(job) });
+  push_heap(queue.begin(), queue.end());
+
+  runQueued(/*all=*/false);
+}
+
+/*
+ * fork queued jobs, cheapest key first, while there are free slots. if
+ * all is set or the queue is over its limit, block until enough slots
+ * free up.
+ */
+void parallel::runQueued(bool all) {
+  while (!queue.empty()) {
+    if (active_children >= max_active_children) {
+      if (!all && queue.size() <= max_queued_jobs)
+        return;
+      readFromChildren(/*blocking=*/true);
+      reapZombies();
+      continue;
+    }
+
+    pop_heap(queue.begin(), queue.end());
+    auto job = std::move(queue.back());
+    queue.pop_back();
+
+    getToken();
+    auto [pid, osp, index] = forkChild(job.index);
+    if (pid == -1) {
+      perror("fork() failed");
+      exit(-1);
+    }
+    if (pid == 0) {
+      job.run(*osp);
+      finishChild(/*is_timeout=*/false);
+      exit(0);
+    }
+  }
+}
+
 /*
  * return true iff we got a state change from a child process (either
  * data or an EOF); if blocking, don't return until there is a state
@@ -125,10 +272,42 @@ std::tuple<pid_t, std::ostream *, int> parallel::limitedFork() {
  * if blocking, only return false when all children have returned EOF
  */
 bool parallel::readFromChildren(bool blocking) {
-  const int maxRead = 16 * 4096;
-  static char data[maxRead];
   if (active_children == 0)
     return false;
+#ifdef __linux__
+  int res;
+  do {
+    res = epoll_wait(epoll_fd, events.data(), events.size(),
+                     blocking ? -1 : 0);
+  } while (res == -1 && errno == EINTR);
+  if (res == -1) {
+    perror("epoll_wait");
+    exit(-1);
+  }
+  if (res == 0) {
+    assert(!blocking);
+    return false;
+  }
+  for (int i = 0; i < res; ++i) {
+    uint64_t key = events[i].data.u64;
+    childProcess &c = children[key >> 1];
+    if (key & 1) {
+      int status;
+      rusage usage;
+      if (wait4(c.pid, &status, WNOHANG, &usage) == c.pid)
+        recordExit(c.pid, status, usage);
+      /*
+       * a child forked concurrently may still hold a copy of the
+       * pidfd, so closing it does not remove it from the epoll set
+       */
+      ENSURE(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c.pidfd, nullptr) == 0);
+      ENSURE(close(c.pidfd) == 0);
+      c.pidfd = -1;
+    } else if (!c.eof) {
+      readFromChild(c);
+    }
+  }
+#else
   int res = poll(pfd.data(), max_active_children, blocking ? -1 : 0);
   if (res == -1) {
     perror("poll");
@@ -142,20 +321,120 @@ bool parallel::readFromChildren(bool blocking) {
     if (pfd[i].revents == 0)
       continue;
     childProcess &c = children[pfd_map.at(i)];
-    size_t size = read(c.pipe[0], data, maxRead);
-    assert(size != (size_t)-1);
+    readFromChild(c);
+    if (c.eof)
+      pfd[i].fd = -1;
+  }
+#endif
+  emitOutput();
+  return true;
+}
+
+/*
+ * read whatever is available from the pipe of a child. the pipe is
+ * non-blocking and edge-triggered on Linux, so we read until it is
+ * drained there.
+ */
+void parallel::readFromChild(childProcess &c) {
+  const int maxRead = 16 * 4096;
+  static char data[maxRead];
+  while (true) {
+    ssize_t size = read(c.pipe[0], data, maxRead);
+    if (size == -1) {
+      if (errno == EINTR)
+        continue;
+      assert(errno == EAGAIN || errno == EWOULDBLOCK);
+      return;
+    }
     if (size == 0) {
       c.eof = true;
+#ifdef __linux__
+      ENSURE(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c.pipe[0], nullptr) == 0);
+#endif
       ENSURE(close(c.pipe[0]) == 0);
       --active_children;
-      pfd[i].fd = -1;
-    } else {
-      c.output.write(data, size);
+      return;
+    }
+    appendOutput(c, data, size);
+#ifndef __linux__
+    // with poll(), return to the event loop after each read
+    return;
+#endif
+  }
+}
+
+void parallel::appendOutput(childProcess &c, const char *data, size_t size) {
+  if (c.spill_fd != -1) {
+    ENSURE(pwrite(c.spill_fd, data, size, c.spill_size) == (ssize_t)size);
+    c.spill_size += size;
+    return;
+  }
+  c.output.write(data, size);
+  c.output_size += size;
+  buffered_bytes += size;
+
+  // spill the largest buffers first, so that few children need a file
+  while (buffered_bytes > max_buffered_bytes) {
+    childProcess *largest = nullptr;
+    for (auto &other : children) {
+      if (other.spill_fd == -1 && other.output_size != 0 &&
+          (!largest || other.output_size > largest->output_size))
+        largest = &other;
     }
+    if (!largest || !spillOutput(*largest))
+      break;
   }
+}
+
+/*
+ * move the in-memory output of a child to a temporary file; the file
+ * is unlinked right away so that it goes away with the parent. returns
+ * false if the file couldn't be created, leaving the output in memory
+ */
+bool parallel::spillOutput(childProcess &c) {
+  c.spill_fd = util::open_anonymous_tmpfile();
+  if (c.spill_fd == -1)
+    return false;
+
+  auto str = std::move(c.output).str();
+  stringstream().swap(c.output);
+  ENSURE(pwrite(c.spill_fd, str.data(), str.size(), 0) == (ssize_t)str.size());
+  c.spill_size = str.size();
+  buffered_bytes -= c.output_size;
+  c.output_size = 0;
   return true;
 }
 
+/*
+ * write everything we have received so far from a child to out_file
+ */
+void parallel::flushOutput(childProcess &c) {
+  if (c.spill_fd != -1) {
+    const size_t bufSize = 16 * 4096;
+    static char buf[bufSize];
+    for (off_t off = 0; off < c.spill_size; ) {
+      ssize_t size = pread(c.spill_fd, buf, bufSize, off);
+      assert(size > 0);
+      out_file.write(buf, size);
+      off += size;
+    }
+    if (c.eof) {
+      ENSURE(close(c.spill_fd) == 0);
+      c.spill_fd = -1;
+    } else {
+      ENSURE(ftruncate(c.spill_fd, 0) == 0);
+    }
+    c.spill_size = 0;
+    return;
+  }
+  if (c.output_size == 0)
+    return;
+  out_file << std::move(c.output).str();
+  stringstream().swap(c.output); // free the RAM
+  buffered_bytes -= c.output_size;
+  c.output_size = 0;
+}
+
 /*
  * wrapper for write() that correctly handles short writes
  */
@@ -174,6 +453,15 @@ static ssize_t safe_write(int fd, const void *void_buf, size_t count) {
   return written;
 }
 
+void parallel::flushChild() {
+  ensureChild();
+  childProcess &me = children[my_index];
+  auto data = std::move(me.output).str();
+  me.output.str({});
+  auto size = data.size();
+  ENSURE(safe_write(me.pipe[1], data.c_str(), size) == (ssize_t)size);
+}
+
 /*
  * if is_timeout is true, we in signal handling context and can only
  * call async-safe functions
@@ -190,60 +478,123 @@ void parallel::finishChild(bool is_timeout) {
     const char *msg = "ERROR: Timeout asynchronous\n\n";
     safe_write(fd_to_parent, msg, std::strlen(msg));
   } else {
-    childProcess &me = children.back();
-    auto data = std::move(me.output).str();
-    auto size = data.size();
-    ENSURE(safe_write(me.pipe[1], data.c_str(), size) == (ssize_t)size);
+    flushChild();
   }
 }
 
 void parallel::finishParent() {
   ensureParent();
+  runQueued(/*all=*/true);
   while (readFromChildren(/*blocking=*/true))
     reapZombies();
   assert(active_children == 0);
-  while (wait(nullptr) != -1)
-    ;
+  int status;
+  rusage usage;
+  pid_t pid;
+  while ((pid = wait4((pid_t)-1, &status, 0, &usage)) != -1)
+    recordExit(pid, status, usage);
+  for (auto &c : children) {
+    if (c.pidfd != -1) {
+      ENSURE(close(c.pidfd) == 0);
+      c.pidfd = -1;
+    }
+  }
+  // terminate a trailing incomplete line so that it gets emitted
+  if (parent_ss.tellp() > 0)
+    parent_ss << '\n';
   ENSURE(emitOutput());
 }
 
+static double seconds(const timeval &tv) {
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void parallel::printUsage(const childProcess &c) {
+#ifdef __APPLE__
+  double max_rss = c.usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+  double max_rss = c.usage.ru_maxrss / 1024.0; // KB
+#endif
+  auto flags = out_file.flags();
+  auto precision = out_file.precision();
+  out_file << fixed << setprecision(2)
+           << "Process resource usage: user " << seconds(c.usage.ru_utime)
+           << "s, sys " << seconds(c.usage.ru_stime)
+           << "s, max RSS " << max_rss << " MB, page faults "
+           << c.usage.ru_majflt << " major / " << c.usage.ru_minflt
+           << " minor, wall " << c.wall_time << 's';
+  if (c.estimated_cost >= 0)
+    out_file << ", estimated cost " << c.estimated_cost;
+  if (WIFSIGNALED(c.status))
+    out_file << ", killed by signal " << WTERMSIG(c.status);
+  out_file << "\n\n";
+  out_file.flags(flags);
+  out_file.precision(precision);
+}
+
+/*
+ * move the text that the parent has written so far into the queue of
+ * pending output, splitting it at the include(N) placeholders. a
+ * trailing incomplete line is left in parent_ss.
+ */
+void parallel::drainParent() {
+  auto data = std::move(parent_ss).str();
+  parent_ss.str("");
+  parent_ss.clear();
+
+  string_view text(data);
+  auto last_nl = text.rfind('\n');
+  if (last_nl == string_view::npos) {
+    parent_ss << text;
+    return;
+  }
+  parent_ss << text.substr(last_nl + 1);
+  text = text.substr(0, last_nl + 1);
+
+  auto add_text = [&](string_view str) {
+    if (str.empty())
+      return;
+    if (pending.empty() || pending.back().child != -1)
+      pending.emplace_back();
+    pending.back().text += str;
+  };
+
+  while (!text.empty()) {
+    auto nl = text.find('\n');
+    auto line = text.substr(0, nl + 1);
+    text = text.substr(nl + 1);
+
+    if (line.starts_with("include(")) {
+      auto index = strtol(line.substr(sizeof("include(")-1).data(), nullptr,
+                          10);
+      pending.emplace_back().child = index;
+    } else {
+      add_text(line);
+    }
+  }
+}
+
 /*
+ * write all output whose predecessors have completed. the output of
+ * the first unfinished child is streamed as it arrives.
  * return true iff end of output has been reached
  */
 bool parallel::emitOutput() {
   ensureParent();
-  std::string line;
-  while (getline(parent_ss, line)) {
-    if (line.starts_with("include(")) {
-      auto index = strtol(string_view(line).substr(sizeof("include(")-1).data(),
-                          nullptr, 10);
-      if (children[index].eof) {
-        out_file << std::move(children[index].output).str();
-        stringstream().swap(children[index].output); // free the RAM
-      } else {
-        /*
-         * here, for two reasons, we swap parent_ss with a fresh one
-         * containing a copy of the unwritten data. first, we've
-         * already grabbed one line too many from parent_ss, and we
-         * don't have a good way to put it back. second, we want to
-         * free the RAM associated with data we've already read out of
-         * the stringstream.
-         */
-        stringstream new_ss;
-        new_ss << line << '\n';
-        auto cur = parent_ss.tellg();
-        new_ss << string_view(std::move(parent_ss).str()).substr(cur);
-        parent_ss = std::move(new_ss);
+  drainParent();
+  while (!pending.empty()) {
+    auto &p = pending.front();
+    if (p.child != -1) {
+      childProcess &c = children[p.child];
+      flushOutput(c);
+      if (!c.eof || (report_usage && !c.reaped))
         return false;
-      }
+      if (report_usage)
+        printUsage(c);
     } else {
-      out_file << line << '\n';
+      out_file << p.text;
     }
+    pending.pop_front();
   }
-  /*
-   * reset the EOF flag since this process is going to keep writing
-   * into parent_ss
-   */
-  parent_ss.clear();
   return true;
 }
@@ -3,39 +3,129 @@
 // Copyright (c) 2018-present The Alive2 Authors.
 // Distributed under the MIT license that can be found in the LICENSE file.
 
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <optional>
 #include <ostream>
 #include <poll.h>
 #include <sstream>
+#include <string>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <tuple>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <unordered_map>
 #include <vector>
 
 struct childProcess {
-  int pipe[2];
-  pid_t pid;
+  int pipe[2] = {-1, -1};
+  pid_t pid = -1;
   /*
    * in a child process, this buffers its output until it is ready to
    * exit. for the parent process, this child's output is stored in
-   * this buffer until we're ready to finally dump it when all
-   * children have finished.
+   * this buffer until all output that precedes it has been emitted.
    */
   std::stringstream output;
+  size_t output_size = 0;
+  /*
+   * parent only: once the in-memory output of the children exceeds
+   * the limit, further output of this child goes to an unlinked
+   * temporary file
+   */
+  int spill_fd = -1;
+  off_t spill_size = 0;
+  // parent only: becomes readable when the child exits (Linux)
+  int pidfd = -1;
   bool eof = false;
+  // raw wait() status and resource usage, valid once the child has
+  // been reaped
+  int status = 0;
+  rusage usage{};
+  bool reaped = false;
+  // parent only: for comparing the actual cost of a job with its estimate
+  std::chrono::steady_clock::time_point start;
+  double wall_time = 0;
+  double estimated_cost = -1;
 };
 
+/*
+ * order in which queued jobs are started: in submission order, or by
+ * estimated cost -- cheapest first for latency, or most expensive first
+ * to minimize the makespan
+ */
+enum class schedule { fifo, shortest_first, longest_first };
+
 class parallel {
   pid_t parent_pid = -1;
   int max_active_children;
   int fd_to_parent;
+  int my_index = -1;
   int active_children = 0;
+#ifdef __linux__
+  /*
+   * the read ends of the pipes and the pidfds of the children are
+   * registered in an epoll instance; a child that could not get a
+   * pidfd is reaped with waitpid() instead
+   */
+  int epoll_fd = -1;
+  bool reap_with_waitpid = false;
+  std::vector<epoll_event> events;
+#else
   std::vector<pollfd> pfd;
   std::vector<int> pfd_map;
+#endif
   std::vector<childProcess> children;
+  std::unordered_map<pid_t, int> pid_map;
+
+protected:
   std::stringstream &parent_ss;
   std::ostream &out_file;
+
+private:
+
+  /*
+   * output that has not been written to out_file yet, in order: text
+   * from the parent (child == -1) or the output of a child process
+   */
+  struct pendingOutput {
+    std::string text;
+    int child = -1;
+  };
+  std::deque<pendingOutput> pending;
+  size_t buffered_bytes = 0;
+  size_t max_buffered_bytes = 64 * 1024 * 1024;
+  bool report_usage = false;
+
+  struct queuedJob {
+    double key;
+    int index;
+    std::function<void(std::ostream&)> run;
+    // max-heap on the inverted key, ties broken by submission order
+    bool operator<(const queuedJob &other) const {
+      return key != other.key ? key > other.key : index > other.index;
+    }
+  };
+  std::vector<queuedJob> queue;
+  schedule policy = schedule::fifo;
+  size_t max_queued_jobs = 0;
+
   void ensureParent();
   void ensureChild();
+  void recordExit(pid_t pid, int status, const rusage &usage);
+  void printUsage(const childProcess &c);
   void reapZombies();
+  void waitForSlot();
+  std::tuple<pid_t, std::ostream *, int> forkChild(int index);
+  void runQueued(bool all);
+  void readFromChild(childProcess &c);
+  void drainParent();
+  void appendOutput(childProcess &c, const char *data, size_t size);
+  bool spillOutput(childProcess &c);
+  void flushOutput(childProcess &c);
   bool emitOutput();
   bool readFromChildren(bool blocking);
 
@@ -44,7 +134,7 @@ public:
            std::ostream &out_file)
       : max_active_children(max_active_children), parent_ss(parent_ss),
         out_file(out_file) {}
-  virtual ~parallel() {}
+  virtual ~parallel();
 
   /*
    * must be called before any other methods are used, and this object
@@ -52,6 +142,19 @@ public:
    */
   virtual bool init();
 
+  /*
+   * bound on the output of child processes that the parent keeps in
+   * memory while waiting for earlier output to complete; output beyond
+   * this is spilled to temporary files
+   */
+  void setMaxBufferedOutput(size_t bytes) { max_buffered_bytes = bytes; }
+
+  /*
+   * append the CPU time, max RSS, and page faults of each child
+   * process, as reported by wait4(), to its output
+   */
+  void setReportResourceUsage(bool yes) { report_usage = yes; }
+
   virtual void getToken() = 0;
   virtual void putToken() = 0;
 
@@ -66,6 +169,24 @@ public:
    */
   virtual std::tuple<pid_t, std::ostream *, int> limitedFork() = 0;
 
+  /*
+   * alternative to limitedFork(), called from parent: queue a job to be
+   * run in a child process and leave a placeholder for its output in
+   * parent_ss. jobs are started in the order given by the scheduling
+   * policy as slots free up; up to max_queued jobs may be waiting
+   * before this blocks. the job receives the stream for its output and
+   * the child exits once it returns.
+   */
+  void setSchedule(schedule policy, size_t max_queued);
+  virtual void enqueue(double cost,
+                       std::function<void(std::ostream&)> &&job);
+
+  /*
+   * called from a child; sends its output so far to the parent, so that
+   * long-running children don't have to buffer all of it
+   */
+  void flushChild();
+
   /*
    * called from a child that has finished executing
    */
@@ -76,6 +197,12 @@ public:
    * terminated
    */
   virtual void finishParent() = 0;
+
+  /*
+   * called from parent; returns the wait() status of the given child
+   * if it has already been reaped
+   */
+  std::optional<int> getExitStatus(int index) const;
 };
 
 class fifo final : public parallel {
@@ -114,6 +241,8 @@ public:
       : parallel(max_active_children, parent_ss, out_file) {}
   bool init() override;
   std::tuple<pid_t, std::ostream *, int> limitedFork() override;
+  void enqueue(double cost,
+               std::function<void(std::ostream&)> &&job) override;
   void finishChild(bool is_timeout) override;
   void finishParent() override;
   void getToken() override;